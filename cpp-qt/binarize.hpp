@@ -38,6 +38,7 @@
 
 #include <QImage>
 #include <QColor>
+#include <QVector>
 
 #include "thresholding.h"
 
@@ -84,7 +85,25 @@ QImage binarize(const QImage& origin, Predicate predicate)
 inline QImage binarize(const QImage& origin, int threshold)
 {
     Q_ASSUME(threshold>=0&&threshold<0x100);
-    return binarize(origin,[=](QRgb pixel){return qGray(pixel)>threshold;});
+    return binarizeBetween(origin,threshold,0xFF);
+}
+
+/*!
+    \overload binarize
+
+    Create a binary image from \a origin, by replacing pixels in the
+    \a foreground class of the ascending \a thresholds with 1 and others
+    with 0. A pixel belongs to the class \c i if its gray level is above
+    i thresholds.
+
+    \sa clusterThresholds()
+ */
+inline QImage binarize(const QImage& origin, const QVector<int>& thresholds, int foreground)
+{
+    Q_ASSUME(foreground>=0&&foreground<=thresholds.size());
+    return binarizeBetween(origin,
+                           foreground>0 ? thresholds.at(foreground-1) : -1,
+                           foreground<thresholds.size() ? thresholds.at(foreground) : 0xFF);
 }
 
 /*!
@@ -100,16 +119,25 @@ inline QImage binarize(const QImage& origin, int threshold)
 inline QImage binarize(const QImage& origin,
                        AutoThresholdMethod method = AutoThresholdMethod::Otsu)
 {
+    const HistogramStats stats(grayscaleHistogram(origin));
     switch (method)
     {
     case AutoThresholdMethod::Cluster:
-        return binarize(origin,clusterThreshold(origin));
+        return binarize(origin,clusterThreshold(stats));
     case AutoThresholdMethod::Mean:
-        return binarize(origin,meanThreshold(origin));
+        return binarize(origin,meanThreshold(stats));
     case AutoThresholdMethod::Moments:
-        return binarize(origin,momentsThreshold(origin));
+        return binarize(origin,momentsThreshold(stats));
     case AutoThresholdMethod::Fuzziness:
-        return binarize(origin,fuzzinessThreshold(origin));
+        return binarize(origin,fuzzinessThreshold(stats));
+    case AutoThresholdMethod::Entropy:
+        return binarize(origin,entropyThreshold(stats));
+    case AutoThresholdMethod::MinimumError:
+        return binarize(origin,minimumErrorThreshold(stats));
+    case AutoThresholdMethod::Triangle:
+        return binarize(origin,triangleThreshold(stats));
+    case AutoThresholdMethod::MultiCluster:
+        return binarize(origin,clusterThresholds(stats,2),2);
     default:
         Q_UNREACHABLE();
         break;
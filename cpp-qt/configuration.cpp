@@ -39,9 +39,18 @@ static constexpr auto DefaultCircleFitMethod = Configuration::SimpleAlgebraicFit
 static constexpr auto DefaultErrorCorrectionMethod = Configuration::NoCorrection;
 static constexpr auto DefaultFilterRadius = 2u;
 static constexpr auto DefaultGaussianSigma = 1.;
+static constexpr auto DefaultRecursiveGaussianCutoff = 3.;
 static constexpr auto DefaultColorRadius = 0.1;
 static constexpr auto DefaultMaxLevel = 1u;
+static constexpr auto DefaultMeanShiftUntilConverged = false;
+static constexpr auto DefaultGuidedFilterEpsilon = 0.001;
 static constexpr auto DefaultPTileValue = 0.5;
+static constexpr auto DefaultLocalThresholdRadius = 15u;
+static constexpr auto DefaultLocalThresholdWeight = 0.2;
+static constexpr auto DefaultClusterThresholdCount = 2u;
+static constexpr auto DefaultForegroundClass = 2u;
+static constexpr auto DefaultCannyLowThreshold = 10.;
+static constexpr auto DefaultCannyHighThreshold = 30.;
 
 /*!
     \internal
@@ -59,9 +68,18 @@ public:
           circleFitMethod(rhs.circleFitMethod),
           filterRadius(rhs.filterRadius),
           gaussianSigma(rhs.gaussianSigma),
+          recursiveGaussianCutoff(rhs.recursiveGaussianCutoff),
           colorRadius(rhs.colorRadius),
           maxLevel(rhs.maxLevel),
-          pTileValue(rhs.pTileValue)
+          meanShiftUntilConverged(rhs.meanShiftUntilConverged),
+          guidedFilterEpsilon(rhs.guidedFilterEpsilon),
+          pTileValue(rhs.pTileValue),
+          localThresholdRadius(rhs.localThresholdRadius),
+          localThresholdWeight(rhs.localThresholdWeight),
+          clusterThresholdCount(rhs.clusterThresholdCount),
+          foregroundClass(rhs.foregroundClass),
+          cannyLowThreshold(rhs.cannyLowThreshold),
+          cannyHighThreshold(rhs.cannyHighThreshold)
     { }
 
     bool operator==(const ConfigurationData& rhs) const
@@ -72,9 +90,18 @@ public:
                 || circleFitMethod == rhs.circleFitMethod
                 || filterRadius == rhs.filterRadius
                 || qFuzzyIsNull(gaussianSigma - rhs.gaussianSigma)
+                || qFuzzyIsNull(recursiveGaussianCutoff - rhs.recursiveGaussianCutoff)
                 || qFuzzyIsNull(colorRadius - rhs.colorRadius)
                 || maxLevel == rhs.maxLevel
-                || qFuzzyIsNull(pTileValue - rhs.pTileValue);
+                || meanShiftUntilConverged == rhs.meanShiftUntilConverged
+                || qFuzzyIsNull(guidedFilterEpsilon - rhs.guidedFilterEpsilon)
+                || qFuzzyIsNull(pTileValue - rhs.pTileValue)
+                || localThresholdRadius == rhs.localThresholdRadius
+                || qFuzzyIsNull(localThresholdWeight - rhs.localThresholdWeight)
+                || clusterThresholdCount == rhs.clusterThresholdCount
+                || foregroundClass == rhs.foregroundClass
+                || qFuzzyIsNull(cannyLowThreshold - rhs.cannyLowThreshold)
+                || qFuzzyIsNull(cannyHighThreshold - rhs.cannyHighThreshold);
     }
 
     Configuration::FilterMethod filterMethod = DefaultFilterMethod;
@@ -84,9 +111,18 @@ public:
     Configuration::ErrorCorrectionMethod errorCorrectionMethod = DefaultErrorCorrectionMethod;
     uint filterRadius = DefaultFilterRadius;
     qreal gaussianSigma = DefaultGaussianSigma;
+    qreal recursiveGaussianCutoff = DefaultRecursiveGaussianCutoff;
     qreal colorRadius = DefaultColorRadius;
     qreal maxLevel = DefaultMaxLevel;
+    bool meanShiftUntilConverged = DefaultMeanShiftUntilConverged;
+    qreal guidedFilterEpsilon = DefaultGuidedFilterEpsilon;
     qreal pTileValue = DefaultPTileValue;
+    uint localThresholdRadius = DefaultLocalThresholdRadius;
+    qreal localThresholdWeight = DefaultLocalThresholdWeight;
+    uint clusterThresholdCount = DefaultClusterThresholdCount;
+    uint foregroundClass = DefaultForegroundClass;
+    qreal cannyLowThreshold = DefaultCannyLowThreshold;
+    qreal cannyHighThreshold = DefaultCannyHighThreshold;
 
 };
 
@@ -167,6 +203,11 @@ qreal Configuration::gaussianSigma() const
     return data->gaussianSigma;
 }
 
+qreal Configuration::recursiveGaussianCutoff() const
+{
+    return data->recursiveGaussianCutoff;
+}
+
 qreal Configuration::colorRadius() const
 {
     return data->colorRadius;
@@ -177,11 +218,51 @@ uint Configuration::maxLevel() const
     return data->maxLevel;
 }
 
+bool Configuration::meanShiftUntilConverged() const
+{
+    return data->meanShiftUntilConverged;
+}
+
+qreal Configuration::guidedFilterEpsilon() const
+{
+    return data->guidedFilterEpsilon;
+}
+
 qreal Configuration::pTileValue() const
 {
     return data->pTileValue;
 }
 
+uint Configuration::localThresholdRadius() const
+{
+    return data->localThresholdRadius;
+}
+
+qreal Configuration::localThresholdWeight() const
+{
+    return data->localThresholdWeight;
+}
+
+uint Configuration::clusterThresholdCount() const
+{
+    return data->clusterThresholdCount;
+}
+
+uint Configuration::foregroundClass() const
+{
+    return data->foregroundClass;
+}
+
+qreal Configuration::cannyLowThreshold() const
+{
+    return data->cannyLowThreshold;
+}
+
+qreal Configuration::cannyHighThreshold() const
+{
+    return data->cannyHighThreshold;
+}
+
 Configuration& Configuration::setFilterMethod(Configuration::FilterMethod method)
 {
     data->filterMethod = method;
@@ -224,6 +305,12 @@ Configuration& Configuration::setGaussianSigma(qreal sigma)
     return *this;
 }
 
+Configuration& Configuration::setRecursiveGaussianCutoff(qreal sigma)
+{
+    data->recursiveGaussianCutoff = sigma;
+    return *this;
+}
+
 Configuration& Configuration::setColorRadius(qreal radius)
 {
     data->colorRadius = radius;
@@ -236,12 +323,60 @@ Configuration& Configuration::setMaxLevel(uint level)
     return *this;
 }
 
+Configuration& Configuration::setMeanShiftUntilConverged(bool untilConverged)
+{
+    data->meanShiftUntilConverged = untilConverged;
+    return *this;
+}
+
+Configuration& Configuration::setGuidedFilterEpsilon(qreal epsilon)
+{
+    data->guidedFilterEpsilon = epsilon;
+    return *this;
+}
+
 Configuration& Configuration::setPTileValue(qreal value)
 {
     data->pTileValue = value;
     return *this;
 }
 
+Configuration& Configuration::setLocalThresholdRadius(uint radius)
+{
+    data->localThresholdRadius = radius;
+    return *this;
+}
+
+Configuration& Configuration::setLocalThresholdWeight(qreal weight)
+{
+    data->localThresholdWeight = weight;
+    return *this;
+}
+
+Configuration& Configuration::setClusterThresholdCount(uint count)
+{
+    data->clusterThresholdCount = count;
+    return *this;
+}
+
+Configuration& Configuration::setForegroundClass(uint index)
+{
+    data->foregroundClass = index;
+    return *this;
+}
+
+Configuration& Configuration::setCannyLowThreshold(qreal threshold)
+{
+    data->cannyLowThreshold = threshold;
+    return *this;
+}
+
+Configuration& Configuration::setCannyHighThreshold(qreal threshold)
+{
+    data->cannyHighThreshold = threshold;
+    return *this;
+}
+
 Configuration::FilterMethod Configuration::defaultFilterMethod()
 {
     return DefaultFilterMethod;
@@ -277,6 +412,11 @@ qreal Configuration::defaultGaussianSigma()
     return DefaultGaussianSigma;
 }
 
+qreal Configuration::defaultRecursiveGaussianCutoff()
+{
+    return DefaultRecursiveGaussianCutoff;
+}
+
 qreal Configuration::defaultColorRadius()
 {
     return DefaultColorRadius;
@@ -287,11 +427,51 @@ qreal Configuration::defaultMaxLevel()
     return DefaultMaxLevel;
 }
 
+bool Configuration::defaultMeanShiftUntilConverged()
+{
+    return DefaultMeanShiftUntilConverged;
+}
+
+qreal Configuration::defaultGuidedFilterEpsilon()
+{
+    return DefaultGuidedFilterEpsilon;
+}
+
 qreal Configuration::defaultPTileValue()
 {
     return DefaultPTileValue;
 }
 
+uint Configuration::defaultLocalThresholdRadius()
+{
+    return DefaultLocalThresholdRadius;
+}
+
+qreal Configuration::defaultLocalThresholdWeight()
+{
+    return DefaultLocalThresholdWeight;
+}
+
+uint Configuration::defaultClusterThresholdCount()
+{
+    return DefaultClusterThresholdCount;
+}
+
+uint Configuration::defaultForegroundClass()
+{
+    return DefaultForegroundClass;
+}
+
+qreal Configuration::defaultCannyLowThreshold()
+{
+    return DefaultCannyLowThreshold;
+}
+
+qreal Configuration::defaultCannyHighThreshold()
+{
+    return DefaultCannyHighThreshold;
+}
+
 /** related non-member **/
 
 bool operator!=(const Configuration& lhs, const Configuration& rhs)
@@ -339,9 +519,18 @@ QDebug operator<<(QDebug dbg, const Configuration& config)
                   << "ErrorCorrectionMethod: " << qPrintable(valueToKey(config.data->errorCorrectionMethod)) << ", "
                   << "FilterRadius: " << config.data->filterRadius << ", "
                   << "GaussianSigma: " << config.data->gaussianSigma << ", "
+                  << "RecursiveGaussianCutoff: " << config.data->recursiveGaussianCutoff << ", "
                   << "ColorRadius: " << config.data->colorRadius << ", "
                   << "MaxLevel: " << config.data->maxLevel << ", "
-                  << "PTileValue: " << config.data->pTileValue << ")";
+                  << "MeanShiftUntilConverged: " << config.data->meanShiftUntilConverged << ", "
+                  << "GuidedFilterEpsilon: " << config.data->guidedFilterEpsilon << ", "
+                  << "PTileValue: " << config.data->pTileValue << ", "
+                  << "LocalThresholdRadius: " << config.data->localThresholdRadius << ", "
+                  << "LocalThresholdWeight: " << config.data->localThresholdWeight << ", "
+                  << "ClusterThresholdCount: " << config.data->clusterThresholdCount << ", "
+                  << "ForegroundClass: " << config.data->foregroundClass << ", "
+                  << "CannyLowThreshold: " << config.data->cannyLowThreshold << ", "
+                  << "CannyHighThreshold: " << config.data->cannyHighThreshold << ")";
 
     return dbg;
 }
@@ -353,9 +542,18 @@ static constexpr const char CircleFitMethodKey[] = "CircleFitMethod";
 static constexpr const char ErrorCorrectionMethodKey[] = "ErrorCorrectionMethod";
 static constexpr const char FilterRadiusKey[] = "FilterRadius";
 static constexpr const char GaussianSigmaKey[] = "GaussianSigma";
+static constexpr const char RecursiveGaussianCutoffKey[] = "RecursiveGaussianCutoff";
 static constexpr const char ColorRadiusKey[] = "ColorRadius";
 static constexpr const char MaxLevelKey[] = "MaxLevel";
+static constexpr const char MeanShiftUntilConvergedKey[] = "MeanShiftUntilConverged";
+static constexpr const char GuidedFilterEpsilonKey[] = "GuidedFilterEpsilon";
 static constexpr const char PTileValueKey[] = "PTileValue";
+static constexpr const char LocalThresholdRadiusKey[] = "LocalThresholdRadius";
+static constexpr const char LocalThresholdWeightKey[] = "LocalThresholdWeight";
+static constexpr const char ClusterThresholdCountKey[] = "ClusterThresholdCount";
+static constexpr const char ForegroundClassKey[] = "ForegroundClass";
+static constexpr const char CannyLowThresholdKey[] = "CannyLowThreshold";
+static constexpr const char CannyHighThresholdKey[] = "CannyHighThreshold";
 
 void saveConfigs(const Configuration& config, QString group)
 {
@@ -368,9 +566,18 @@ void saveConfigs(const Configuration& config, QString group)
     settings.setValue(ErrorCorrectionMethodKey,valueToKey(config.errorCorrectionMethod()));
     settings.setValue(FilterRadiusKey,config.filterRadius());
     settings.setValue(GaussianSigmaKey,config.gaussianSigma());
+    settings.setValue(RecursiveGaussianCutoffKey,config.recursiveGaussianCutoff());
     settings.setValue(ColorRadiusKey,config.colorRadius());
     settings.setValue(MaxLevelKey,config.maxLevel());
+    settings.setValue(MeanShiftUntilConvergedKey,config.meanShiftUntilConverged());
+    settings.setValue(GuidedFilterEpsilonKey,config.guidedFilterEpsilon());
     settings.setValue(PTileValueKey,config.pTileValue());
+    settings.setValue(LocalThresholdRadiusKey,config.localThresholdRadius());
+    settings.setValue(LocalThresholdWeightKey,config.localThresholdWeight());
+    settings.setValue(ClusterThresholdCountKey,config.clusterThresholdCount());
+    settings.setValue(ForegroundClassKey,config.foregroundClass());
+    settings.setValue(CannyLowThresholdKey,config.cannyLowThreshold());
+    settings.setValue(CannyHighThresholdKey,config.cannyHighThreshold());
     settings.endGroup();
 }
 
@@ -386,9 +593,18 @@ Configuration loadConfigs(QString group)
           .setErrorCorrectionMethod(keyToValue(settings.value(ErrorCorrectionMethodKey).toString(),DefaultErrorCorrectionMethod))
           .setFilterRadius(settings.value(FilterRadiusKey,DefaultFilterRadius).toUInt())
           .setGaussianSigma(settings.value(GaussianSigmaKey,DefaultGaussianSigma).toReal())
+          .setRecursiveGaussianCutoff(settings.value(RecursiveGaussianCutoffKey,DefaultRecursiveGaussianCutoff).toReal())
           .setColorRadius(settings.value(ColorRadiusKey,DefaultColorRadius).toReal())
           .setMaxLevel(settings.value(MaxLevelKey,DefaultMaxLevel).toUInt())
-          .setPTileValue(settings.value(PTileValueKey,DefaultPTileValue).toReal());
+          .setMeanShiftUntilConverged(settings.value(MeanShiftUntilConvergedKey,DefaultMeanShiftUntilConverged).toBool())
+          .setGuidedFilterEpsilon(settings.value(GuidedFilterEpsilonKey,DefaultGuidedFilterEpsilon).toReal())
+          .setPTileValue(settings.value(PTileValueKey,DefaultPTileValue).toReal())
+          .setLocalThresholdRadius(settings.value(LocalThresholdRadiusKey,DefaultLocalThresholdRadius).toUInt())
+          .setLocalThresholdWeight(settings.value(LocalThresholdWeightKey,DefaultLocalThresholdWeight).toReal())
+          .setClusterThresholdCount(settings.value(ClusterThresholdCountKey,DefaultClusterThresholdCount).toUInt())
+          .setForegroundClass(settings.value(ForegroundClassKey,DefaultForegroundClass).toUInt())
+          .setCannyLowThreshold(settings.value(CannyLowThresholdKey,DefaultCannyLowThreshold).toReal())
+          .setCannyHighThreshold(settings.value(CannyHighThresholdKey,DefaultCannyHighThreshold).toReal());
     settings.endGroup();
     return config;
 }
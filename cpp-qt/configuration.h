@@ -50,6 +50,9 @@ public:
         GaussianFilter,
         MedianFilter,
         MeanShiftFilter,
+        RecursiveGaussianFilter,
+        BilateralGridFilter,
+        GuidedFilter,
     };
     Q_ENUM(FilterMethod)
 
@@ -60,6 +63,13 @@ public:
         Moments,
         Fuzziness,
         PTile,
+        Entropy,
+        MinimumError,
+        Triangle,
+        Niblack,
+        Sauvola,
+        Bradley,
+        MultiCluster,
     };
     Q_ENUM(ThresholdingMethod)
 
@@ -69,6 +79,8 @@ public:
         Prewitt,
         Scharr,
         Laplacian,
+        Boundary,
+        Canny,
     };
     Q_ENUM(EdgeDetectionMethod)
 
@@ -95,9 +107,18 @@ public:
     ErrorCorrectionMethod errorCorrectionMethod() const;
     uint filterRadius() const;
     qreal gaussianSigma() const;
+    qreal recursiveGaussianCutoff() const;
     qreal colorRadius() const;
     uint maxLevel() const;
+    bool meanShiftUntilConverged() const;
+    qreal guidedFilterEpsilon() const;
     qreal pTileValue() const;
+    uint localThresholdRadius() const;
+    qreal localThresholdWeight() const;
+    uint clusterThresholdCount() const;
+    uint foregroundClass() const;
+    qreal cannyLowThreshold() const;
+    qreal cannyHighThreshold() const;
 
     Configuration& setFilterMethod(FilterMethod method);
     Configuration& setThresholdingMethod(ThresholdingMethod method);
@@ -106,9 +127,18 @@ public:
     Configuration& setErrorCorrectionMethod(ErrorCorrectionMethod method);
     Configuration& setFilterRadius(uint radius);
     Configuration& setGaussianSigma(qreal sigma);
+    Configuration& setRecursiveGaussianCutoff(qreal sigma);
     Configuration& setColorRadius(qreal radius);
     Configuration& setMaxLevel(uint level);
+    Configuration& setMeanShiftUntilConverged(bool untilConverged);
+    Configuration& setGuidedFilterEpsilon(qreal epsilon);
     Configuration& setPTileValue(qreal value);
+    Configuration& setLocalThresholdRadius(uint radius);
+    Configuration& setLocalThresholdWeight(qreal weight);
+    Configuration& setClusterThresholdCount(uint count);
+    Configuration& setForegroundClass(uint index);
+    Configuration& setCannyLowThreshold(qreal threshold);
+    Configuration& setCannyHighThreshold(qreal threshold);
 
     static FilterMethod defaultFilterMethod();
     static ThresholdingMethod defaultThresholdingMethod();
@@ -117,9 +147,18 @@ public:
     static ErrorCorrectionMethod defaultErrorCorrectionMethod();
     static uint defaultFilterRadius();
     static qreal defaultGaussianSigma();
+    static qreal defaultRecursiveGaussianCutoff();
     static qreal defaultColorRadius();
     static qreal defaultMaxLevel();
+    static bool defaultMeanShiftUntilConverged();
+    static qreal defaultGuidedFilterEpsilon();
     static qreal defaultPTileValue();
+    static uint defaultLocalThresholdRadius();
+    static qreal defaultLocalThresholdWeight();
+    static uint defaultClusterThresholdCount();
+    static uint defaultForegroundClass();
+    static qreal defaultCannyLowThreshold();
+    static qreal defaultCannyHighThreshold();
 
     friend bool operator!=(const Configuration& lhs, const Configuration& rhs);
     friend bool operator==(const Configuration& lhs, const Configuration& rhs);
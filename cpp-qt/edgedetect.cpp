@@ -35,48 +35,336 @@
     \sa <imagefilter.h>
  */
 
+#include <QImage>
+#include <QVector>
+#include <QPoint>
+#include <QSize>
+#include <QtAlgorithms>
+#include <QtEndian>
+#include <cmath>
+#include <cstdlib>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "utils.h"
+
 namespace MEMS {
 
+/*!
+    \enum GradientNorm
+
+    This enum lists the norms to combine the two directional derivatives of
+    gradient operators into the gradient magnitude.
+
+    \value Euclidean
+           The square root of the sum of squares, which is exact.
+    \value Manhattan
+           The sum of absolute values, a cheaper approximation.
+    \value Chebyshev
+           The maximum of absolute values, a cheaper approximation.
+
+    \omitvalue Euclidean
+    \omitvalue Manhattan
+    \omitvalue Chebyshev
+ */
+
+/*!
+    \internal
+
+    Combine derivatives \a gx and \a gy into the gradient magnitude, saturated to 255.
+ */
+static inline uchar gradientMagnitude(int gx, int gy, GradientNorm norm)
+{
+    using ::std::abs;
+
+    switch (norm)
+    {
+    case GradientNorm::Euclidean:
+    {
+        // floor(sqrt(n)) is exact in single precision for n < 2^16
+        const int square = gx*gx+gy*gy;
+        return square>=0x10000 ? 0xff : static_cast<uchar>(::std::sqrt(static_cast<float>(square)));
+    }
+    case GradientNorm::Manhattan:
+        return qMin(abs(gx)+abs(gy),0xff);
+    case GradientNorm::Chebyshev:
+        return qMin(qMax(abs(gx),abs(gy)),0xff);
+    default:
+        Q_UNREACHABLE();
+        break;
+    }
+    return 0;
+}
+
+#ifdef __SSE2__
+/*!
+    \internal
+ */
+static inline __m128i absEpi16(__m128i v)
+{
+    return _mm_max_epi16(v,_mm_sub_epi16(_mm_setzero_si128(),v));
+}
+
+/*!
+    \internal
+
+    SIMD version of gradientMagnitude() for 8 derivatives in 16-bit lanes.
+ */
+static inline __m128i gradientMagnitude(__m128i gx, __m128i gy, GradientNorm norm)
+{
+    switch (norm)
+    {
+    case GradientNorm::Euclidean:
+    {
+        const __m128 limit = _mm_set1_ps(65535.f);
+        const __m128i lo = _mm_unpacklo_epi16(gx,gy);
+        const __m128i hi = _mm_unpackhi_epi16(gx,gy);
+        const __m128 squareLo = _mm_min_ps(_mm_cvtepi32_ps(_mm_madd_epi16(lo,lo)),limit);
+        const __m128 squareHi = _mm_min_ps(_mm_cvtepi32_ps(_mm_madd_epi16(hi,hi)),limit);
+        return _mm_packs_epi32(_mm_cvttps_epi32(_mm_sqrt_ps(squareLo)),
+                               _mm_cvttps_epi32(_mm_sqrt_ps(squareHi)));
+    }
+    case GradientNorm::Manhattan:
+        return _mm_adds_epi16(absEpi16(gx),absEpi16(gy));
+    case GradientNorm::Chebyshev:
+        return _mm_max_epi16(absEpi16(gx),absEpi16(gy));
+    default:
+        Q_UNREACHABLE();
+        break;
+    }
+    return _mm_setzero_si128();
+}
+#endif // __SSE2__
+
+/*!
+    \internal
+
+    Compute the gradient magnitude of \a length samples of a row,
+    whose neighbor samples are \a step bytes away.
+    The rows \a up, \a middle, and \a down are extended by \a step bytes on both sides.
+
+    The derivative is a central difference in one direction and a smoothing of
+    weights (\c Side, \c Center, \c Side) in the other direction.
+ */
+template<int Side, int Center>
+static void gradientRow(const uchar* up, const uchar* middle, const uchar* down,
+                        const int length, const int step, GradientNorm norm, uchar* out)
+{
+    const uchar* u0 = up;
+    const uchar* u1 = up+step;
+    const uchar* u2 = up+2*step;
+    const uchar* m0 = middle;
+    const uchar* m2 = middle+2*step;
+    const uchar* d0 = down;
+    const uchar* d1 = down+step;
+    const uchar* d2 = down+2*step;
+
+    int k = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i side = _mm_set1_epi16(Side);
+    const __m128i center = _mm_set1_epi16(Center);
+    // takes the 16-bit samples, widened from either half of the loaded bytes
+    const auto derivatives = [&](const __m128i* w, __m128i& gx, __m128i& gy) {
+        const __m128i U0 = w[0], U1 = w[1], U2 = w[2];
+        const __m128i M0 = w[3], M2 = w[4];
+        const __m128i D0 = w[5], D1 = w[6], D2 = w[7];
+        gx = _mm_add_epi16(_mm_mullo_epi16(_mm_add_epi16(_mm_sub_epi16(U2,U0),_mm_sub_epi16(D2,D0)),side),
+                           _mm_mullo_epi16(_mm_sub_epi16(M2,M0),center));
+        gy = _mm_add_epi16(_mm_mullo_epi16(_mm_add_epi16(_mm_sub_epi16(D0,U0),_mm_sub_epi16(D2,U2)),side),
+                           _mm_mullo_epi16(_mm_sub_epi16(D1,U1),center));
+    };
+    for (; k+16<=length; k+=16)
+    {
+        const __m128i v[8] = {
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(u0+k)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(u1+k)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(u2+k)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(m0+k)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(m2+k)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(d0+k)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(d1+k)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(d2+k)),
+        };
+        __m128i lo[8], hi[8];
+        for (int i=0; i<8; ++i)
+        {
+            lo[i] = _mm_unpacklo_epi8(v[i],zero);
+            hi[i] = _mm_unpackhi_epi8(v[i],zero);
+        }
+        __m128i gxLo, gyLo, gxHi, gyHi;
+        derivatives(lo,gxLo,gyLo);
+        derivatives(hi,gxHi,gyHi);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out+k),
+                         _mm_packus_epi16(gradientMagnitude(gxLo,gyLo,norm),
+                                          gradientMagnitude(gxHi,gyHi,norm)));
+    }
+#endif // __SSE2__
+    for (; k<length; ++k)
+    {
+        const int gx = Side*(u2[k]-u0[k]+d2[k]-d0[k]) + Center*(m2[k]-m0[k]);
+        const int gy = Side*(d0[k]-u0[k]+d2[k]-u2[k]) + Center*(d1[k]-u1[k]);
+        out[k] = gradientMagnitude(gx,gy,norm);
+    }
+}
+
+/*!
+    \internal
+
+    Compute the Laplacian of \a length samples of a row, saturated to [0, 255].
+
+    \sa gradientRow()
+ */
+static void laplacianRow(const uchar* up, const uchar* middle, const uchar* down,
+                         const int length, const int step, uchar* out)
+{
+    const uchar* u1 = up+step;
+    const uchar* m0 = middle;
+    const uchar* m1 = middle+step;
+    const uchar* m2 = middle+2*step;
+    const uchar* d1 = down+step;
+
+    int k = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    // takes the 16-bit samples, widened from either half of the loaded bytes
+    const auto laplacian = [](const __m128i* w) {
+        const __m128i sum = _mm_add_epi16(_mm_add_epi16(w[0],w[1]),_mm_add_epi16(w[2],w[4]));
+        return _mm_sub_epi16(sum,_mm_slli_epi16(w[3],2));
+    };
+    for (; k+16<=length; k+=16)
+    {
+        const __m128i v[5] = {
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(u1+k)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(m0+k)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(m2+k)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(m1+k)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(d1+k)),
+        };
+        __m128i lo[5], hi[5];
+        for (int i=0; i<5; ++i)
+        {
+            lo[i] = _mm_unpacklo_epi8(v[i],zero);
+            hi[i] = _mm_unpackhi_epi8(v[i],zero);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out+k),
+                         _mm_packus_epi16(laplacian(lo),laplacian(hi)));
+    }
+#endif // __SSE2__
+    for (; k<length; ++k)
+    {
+        out[k] = qBound(0,u1[k]+m0[k]+m2[k]+d1[k]-4*m1[k],0xff);
+    }
+}
+
+/*!
+    \internal
+
+    Run \a rowOperator on every row of \a image with fixed padding.
+
+    Grayscale (including binary) images are processed in a single 8-bit channel.
+ */
+template<typename RowOperator>
+static QImage operator3x3(const QImage& image, RowOperator rowOperator)
+{
+    const QImage::Format format = image.allGray() ? QImage::Format_Grayscale8
+                                                  : QImage::Format_RGB32;
+    QImage output(image.size(),format);
+    const QImage input = image.convertToFormat(format);
+
+    const int width = image.width();
+    const int height = image.height();
+    const int step = format==QImage::Format_RGB32 ? sizeof(QRgb) : 1;
+    const int length = step*width;
+    const int extLength = length+2*step;
+
+    // repeat the boundary pixels on the left and right
+    QVector<uchar> extended(extLength*height);
+    for (int y=0; y<height; ++y)
+    {
+        const uchar* iLine = input.constScanLine(y);
+        uchar* eLine = extended.data()+extLength*y;
+        ::std::copy(iLine,iLine+step,eLine);
+        ::std::copy(iLine,iLine+length,eLine+step);
+        ::std::copy(iLine+length-step,iLine+length,eLine+step+length);
+    }
+
+    uchar* const outputBits = output.bits();
+    const int outputStride = output.bytesPerLine();
+    parallelForRows(height,length,[&](int begin, int end){
+        for (int y=begin; y<end; ++y)
+        {
+            const auto extLine = [&](int yy) {
+                return extended.constData()+extLength*qBound(0,yy,height-1);
+            };
+            uchar* line = outputBits+y*outputStride;
+            rowOperator(extLine(y-1),extLine(y),extLine(y+1),length,step,line);
+            if (format==QImage::Format_RGB32)
+            {
+                QRgb* rgbLine = reinterpret_cast<QRgb*>(line);
+                for (int x=0; x<width; ++x)
+                {
+                    rgbLine[x] |= 0xff000000;
+                }
+            }
+        }
+    });
+    MAYBE_INTERRUPT();
+
+    return output.convertToFormat(image.format());
+}
+
+/*!
+    \internal
+
+    The gradient operator of the horizontal kernel \c KerX and its transpose.
+    The weights of the right column of \c KerX are taken at compile time.
+ */
+template<const FixedKernel<3,3>& KerX>
+static QImage gradientOperator(const QImage& image, GradientNorm norm)
+{
+    constexpr int Side = static_cast<int>(KerX.at(0,2));
+    constexpr int Center = static_cast<int>(KerX.at(1,2));
+    static_assert(KerX.at(2,2)==Side && KerX.at(0,0)==-Side && KerX.at(1,0)==-Center,
+                  "The kernel is not an antisymmetric gradient kernel");
+
+    return operator3x3(image,[norm](const uchar* up, const uchar* middle, const uchar* down,
+                                    int length, int step, uchar* out){
+        gradientRow<Side,Center>(up,middle,down,length,step,norm,out);
+    });
+}
+
 /*!
     Sobel operator
+
+    The gradient magnitude is combined with \a norm.
  */
-QImage sobelOperator(const QImage& image)
+QImage sobelOperator(const QImage& image, GradientNorm norm)
 {
-    static const MatrixKernel sobelX{{ {{-1, 0, 1}},
-                                       {{-2, 0, 2}},
-                                       {{-1, 0, 1}} }};
-    static const MatrixKernel sobelY{{ {{ 1, 2, 1}},
-                                       {{ 0, 0, 0}},
-                                       {{-1,-2,-1}} }};
-    return convolveXY(image,sobelX,sobelY,PaddingType::Fixed);
+    // equivalent to convolveXY with SobelKernelX & SobelKernelY
+    return gradientOperator<SobelKernelX>(image,norm);
 }
 
 /*!
     Prewitt operator
+
+    The gradient magnitude is combined with \a norm.
  */
-QImage prewittOperator(const QImage& image)
+QImage prewittOperator(const QImage& image, GradientNorm norm)
 {
-    static const MatrixKernel prewittX{{ {{-1, 0, 1}},
-                                         {{-1, 0, 1}},
-                                         {{-1, 0, 1}} }};
-    static const MatrixKernel prewittY{{ {{-1,-1,-1}},
-                                         {{ 0, 0, 0}},
-                                         {{ 1, 1, 1}} }};
-    return convolveXY(image,prewittX,prewittY,PaddingType::Fixed);
+    // equivalent to convolveXY with PrewittKernelX & PrewittKernelY
+    return gradientOperator<PrewittKernelX>(image,norm);
 }
 
 /*!
     Scharr operator
+
+    The gradient magnitude is combined with \a norm.
  */
-QImage scharrOperator(const QImage& image)
+QImage scharrOperator(const QImage& image, GradientNorm norm)
 {
-    static const MatrixKernel scharrX{{ {{  3, 10,  3}},
-                                        {{  0,  0,  0}},
-                                        {{ -3,-10, -3}} }};
-    static const MatrixKernel scharrY{{ {{  3,  0, -3}},
-                                        {{ 10,  0,-10}},
-                                        {{  3,  0, -3}} }};
-    return convolveXY(image,scharrX,scharrY,PaddingType::Fixed);
+    // equivalent to convolveXY with ScharrKernelX & ScharrKernelY
+    return gradientOperator<ScharrKernelX>(image,norm);
 }
 
 /*!
@@ -84,10 +372,356 @@ QImage scharrOperator(const QImage& image)
  */
 QImage laplacianOperator(const QImage& image)
 {
-    static const MatrixKernel laplacian{{ {{ 0, 1, 0}},
-                                          {{ 1,-4, 1}},
-                                          {{ 0, 1, 0}} }};
-    return convolve(image,laplacian,PaddingType::Fixed);
+    // equivalent to convolve with LaplacianKernel
+    return operator3x3(image,laplacianRow);
+}
+
+/*!
+    \internal
+
+    The marks of the pixels left by the Canny detector.
+ */
+enum CannyMark : uchar
+{
+    NotEdge,
+    WeakEdge,
+    StrongEdge,
+};
+
+/*!
+    \internal
+
+    Mark the pixels of the grayscale \a input with the Canny detector, in row-major order.
+    The pixels of the edge are left as StrongEdge.
+
+    \sa cannyOperator()
+ */
+static QVector<uchar> cannyMarks(const QImage& input, qreal lowThreshold, qreal highThreshold)
+{
+    using ::std::sqrt;
+    using ::std::abs;
+
+    enum Direction : uchar { Horizontal, Diagonal, Vertical, AntiDiagonal };
+
+    const int width = input.width();
+    const int height = input.height();
+
+    // the gradient magnitude and the direction along which it is compared
+    QVector<qreal> magnitudes(width*height);
+    QVector<uchar> directions(width*height);
+    qreal* const magnitudeBits = magnitudes.data();
+    uchar* const directionBits = directions.data();
+    parallelForRows(height,width*sizeof(qreal),[&](int begin, int end){
+        for (int y=begin; y<end; ++y)
+        {
+            const uchar* up = input.constScanLine(qMax(0,y-1));
+            const uchar* middle = input.constScanLine(y);
+            const uchar* down = input.constScanLine(qMin(height-1,y+1));
+            for (int x=0; x<width; ++x)
+            {
+                const int left = qMax(0,x-1);
+                const int right = qMin(width-1,x+1);
+                const int gx = up[right]+2*middle[right]+down[right] - up[left]-2*middle[left]-down[left];
+                const int gy = down[left]+2*down[x]+down[right] - up[left]-2*up[x]-up[right];
+                magnitudeBits[y*width+x] = sqrt(qreal(gx*gx+gy*gy))/4;
+
+                // the tangents of 22.5 and 67.5 degrees, scaled by 10000
+                const int ax = abs(gx);
+                const int ay = abs(gy);
+                directionBits[y*width+x] = 10000*ay <= 4142*ax ? Horizontal
+                                         : 10000*ay >= 24142*ax ? Vertical
+                                         : (gx>0) == (gy>0) ? Diagonal : AntiDiagonal;
+            }
+        }
+    },0,0.4);
+
+    // keep the local maxima along the gradient; a plateau keeps its first pixel,
+    // and the magnitude outside the image is 0 so that edges reaching the border stay
+    QVector<uchar> marks(width*height,NotEdge);
+    uchar* const markBits = marks.data();
+    parallelForRows(height,width*sizeof(qreal),[&](int begin, int end){
+        for (int y=begin; y<end; ++y)
+        {
+            for (int x=0; x<width; ++x)
+            {
+                const qreal magnitude = magnitudes.at(y*width+x);
+                if (magnitude < lowThreshold || magnitude <= 0)
+                    continue;
+                int dx = 0, dy = 0;
+                switch (directions.at(y*width+x))
+                {
+                case Horizontal:   dx = 1; dy = 0; break;
+                case Vertical:     dx = 0; dy = 1; break;
+                case Diagonal:     dx = 1; dy = 1; break;
+                case AntiDiagonal: dx = 1; dy = -1; break;
+                }
+                const auto neighbor = [&](int sign) {
+                    const int xx = x+sign*dx;
+                    const int yy = y+sign*dy;
+                    return xx>=0 && xx<width && yy>=0 && yy<height ? magnitudes.at(yy*width+xx) : 0.;
+                };
+                if (magnitude > neighbor(-1) && magnitude >= neighbor(1))
+                    markBits[y*width+x] = magnitude >= highThreshold ? StrongEdge : WeakEdge;
+            }
+        }
+    },0.4,0.8);
+
+    // hysteresis: grow the strong pixels through their 8-connected weak neighbors
+    QVector<int> stack;
+    for (int i=0; i<marks.size(); ++i)
+    {
+        if (marks.at(i) == StrongEdge)
+            stack.append(i);
+    }
+    while (!stack.isEmpty())
+    {
+        const int i = stack.takeLast();
+        const int x = i%width;
+        const int y = i/width;
+        for (int yy=qMax(0,y-1); yy<=qMin(height-1,y+1); ++yy)
+        {
+            for (int xx=qMax(0,x-1); xx<=qMin(width-1,x+1); ++xx)
+            {
+                if (marks.at(yy*width+xx) == WeakEdge)
+                {
+                    marks[yy*width+xx] = StrongEdge;
+                    stack.append(yy*width+xx);
+                }
+            }
+        }
+    }
+    PROGRESS_UPDATE(0.9);
+
+    return marks;
+}
+
+/*!
+    Canny edge detector
+
+    The gradient of the grayscale \a image is taken with the Sobel kernels and
+    divided by 4, so that its magnitude is the step of gray levels across an edge.
+    Pixels which are not a local maximum of the magnitude along the gradient direction
+    are suppressed, leaving edges one pixel wide. The remaining pixels above
+    \a highThreshold, and those above \a lowThreshold connected to them, form the edge.
+
+    The result is a \c Format_Mono image with the edge pixels set to 1.
+
+    \sa cannyPoints()
+ */
+QImage cannyOperator(const QImage& image, qreal lowThreshold, qreal highThreshold)
+{
+/*!
+    \quotation
+    Canny, J (1986), "A computational approach to edge detection",
+    IEEE Trans. Pattern Analysis and Machine Intelligence 8(6): 679-698
+    \endquotation
+ */
+
+    const QImage input = image.convertToFormat(QImage::Format_Grayscale8);
+    const int width = input.width();
+    const int height = input.height();
+    QImage output(input.size(),QImage::Format_Mono);
+    if (output.isNull())
+        return output;
+
+    const QVector<uchar> marks = cannyMarks(input,lowThreshold,highThreshold);
+    MAYBE_INTERRUPT();
+
+    for (int y=0; y<height; ++y)
+    {
+        uchar* line = output.scanLine(y);
+        ::std::fill_n(line,output.bytesPerLine(),uchar(0));
+        for (int x=0; x<width; ++x)
+        {
+            if (marks.at(y*width+x) == StrongEdge)
+            {
+                line[x>>3] |= (1 << (0b111-(x & 0b111)));
+            }
+        }
+    }
+
+    return output;
+}
+
+/*!
+    The positions of the edge pixels of cannyOperator(), in the order of whitePixelPositions(),
+    without creating the edge image.
+ */
+QVector<QPoint> cannyPoints(const QImage& image, qreal lowThreshold, qreal highThreshold)
+{
+    const QImage input = image.convertToFormat(QImage::Format_Grayscale8);
+    const int width = input.width();
+    if (input.isNull())
+        return {};
+
+    const QVector<uchar> marks = cannyMarks(input,lowThreshold,highThreshold);
+    MAYBE_INTERRUPT();
+
+    QVector<QPoint> points;
+    for (int i=0; i<marks.size(); ++i)
+    {
+        if (marks.at(i) == StrongEdge)
+            points.append({i%width,i/width});
+    }
+    return points;
+}
+
+/*!
+    \internal
+
+    Run \c row(y,edges) for every row of the morphological boundary of the \c Format_Mono \a input,
+    where \c edges are the big-endian 64-bit words of the row with the edge pixels set.
+    The bits beyond the width are cleared. The rows are run in parallel bands.
+
+    \sa boundaryOperator()
+ */
+template<typename RowFunction>
+static void boundaryRows(const QImage& input, RowFunction row)
+{
+    constexpr int WordBits = 64;
+    const int width = input.width();
+    const int height = input.height();
+    const int stride = input.bytesPerLine();
+    const int wordsPerLine = (width+WordBits-1)/WordBits;
+    // the bits beyond the width in the last word
+    const int tail = width%WordBits;
+    const quint64 tailMask = tail ? ~quint64(0)>>tail : 0;
+
+    // the leftmost pixel is the most significant bit of a big-endian word
+    QVector<quint64> words(wordsPerLine*height);
+    quint64* const wordsBits = words.data();
+    parallelForRows(height,stride,[&](int begin, int end){
+        for (int y=begin; y<end; ++y)
+        {
+            const uchar* line = input.constScanLine(y);
+            quint64* wordLine = wordsBits+y*wordsPerLine;
+            for (int i=0; i<wordsPerLine; ++i)
+            {
+                uchar bytes[sizeof(quint64)] = {};
+                ::std::copy_n(line+i*sizeof(quint64),qMin<int>(sizeof(quint64),stride-i*sizeof(quint64)),bytes);
+                wordLine[i] = qFromBigEndian<quint64>(bytes);
+            }
+            // repeat the last pixel beyond the width
+            quint64& last = wordLine[wordsPerLine-1];
+            if (tail)
+                last = ((last>>(WordBits-tail))&1) ? last|tailMask : last&~tailMask;
+        }
+    },0,0.5);
+
+    parallelForRows(height,stride,[&](int begin, int end){
+        QVector<quint64> edges(wordsPerLine);
+        for (int y=begin; y<end; ++y)
+        {
+            const quint64* up = words.constData()+qMax(0,y-1)*wordsPerLine;
+            const quint64* middle = words.constData()+y*wordsPerLine;
+            const quint64* down = words.constData()+qMin(height-1,y+1)*wordsPerLine;
+            for (int i=0; i<wordsPerLine; ++i)
+            {
+                const quint64 word = middle[i];
+                const quint64 leftBit = i>0 ? middle[i-1]&1 : word>>(WordBits-1);
+                const quint64 rightBit = i+1<wordsPerLine ? middle[i+1]>>(WordBits-1) : word&1;
+                const quint64 left = (word>>1) | (leftBit<<(WordBits-1));
+                const quint64 right = (word<<1) | rightBit;
+                edges[i] = word & ~(up[i] & down[i] & left & right);
+            }
+            edges[wordsPerLine-1] &= ~tailMask;
+            row(y,edges.constData());
+        }
+    },0.5,1);
+}
+
+/*!
+    Morphological boundary operator
+
+    The edge of a binary image is the set of pixels set to 1 which have a
+    4-neighbour set to 0, i.e. the set minus its erosion by a 3x3 cross.
+    The pixels outside the image repeat the boundary pixels.
+
+    The \c Format_Mono scanlines are processed as 64-bit words, so that
+    every shift and AND/OR handles 64 pixels at once.
+    Images of other formats are thresholded to \c Format_Mono first.
+
+    \sa boundaryPoints()
+ */
+QImage boundaryOperator(const QImage& image)
+{
+    const QImage input = image.format()==QImage::Format_Mono
+            ? image : image.convertToFormat(QImage::Format_Mono,Qt::ThresholdDither);
+    QImage output(input.size(),QImage::Format_Mono);
+    output.setColorTable(input.colorTable());
+    if (output.isNull())
+        return output;
+
+    uchar* const outputBits = output.bits();
+    const int stride = output.bytesPerLine();
+    boundaryRows(input,[&](int y, const quint64* edges){
+        uchar* line = outputBits+y*stride;
+        for (int i=0; i*int(sizeof(quint64))<stride; ++i)
+        {
+            uchar bytes[sizeof(quint64)];
+            qToBigEndian<quint64>(edges[i],bytes);
+            ::std::copy_n(bytes,qMin<int>(sizeof(quint64),stride-i*sizeof(quint64)),line+i*sizeof(quint64));
+        }
+    });
+    MAYBE_INTERRUPT();
+
+    return output;
+}
+
+/*!
+    The positions of the edge pixels of boundaryOperator(), in the order of whitePixelPositions(),
+    without creating the edge image. They are read off the edge words by counting leading zeros,
+    so the cost of the scan follows the number of words and edge pixels.
+ */
+QVector<QPoint> boundaryPoints(const QImage& image)
+{
+    constexpr int WordBits = 64;
+    const QImage input = image.format()==QImage::Format_Mono
+            ? image : image.convertToFormat(QImage::Format_Mono,Qt::ThresholdDither);
+    const int wordsPerLine = (input.width()+WordBits-1)/WordBits;
+    if (input.isNull())
+        return {};
+
+    QVector<QVector<QPoint>> rows(input.height());
+    boundaryRows(input,[&](int y, const quint64* edges){
+        QVector<QPoint>& points = rows[y];
+        for (int i=0; i<wordsPerLine; ++i)
+        {
+            for (quint64 word=edges[i]; word!=0; )
+            {
+                const int bit = static_cast<int>(qCountLeadingZeroBits(word));
+                points.append({i*WordBits+bit,y});
+                word &= ~(quint64(1)<<(WordBits-1-bit));
+            }
+        }
+    });
+    MAYBE_INTERRUPT();
+
+    QVector<QPoint> points;
+    for (const QVector<QPoint>& row : rows)
+    {
+        points += row;
+    }
+    return points;
+}
+
+/*!
+    Create a \c Format_Mono image of \a size with the pixels at \a points set to 1,
+    i.e. the edge image whose whitePixelPositions() are \a points.
+ */
+QImage edgePointsImage(const QSize& size, const QVector<QPoint>& points)
+{
+    QImage output(size,QImage::Format_Mono);
+    if (output.isNull())
+        return output;
+
+    ::std::fill_n(output.bits(),output.bytesPerLine()*output.height(),uchar(0));
+    for (const QPoint& point : points)
+    {
+        uchar* line = output.scanLine(point.y());
+        line[point.x()>>3] |= (1 << (0b111-(point.x() & 0b111)));
+    }
+    return output;
 }
 
 } // namespace MEMS
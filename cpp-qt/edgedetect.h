@@ -27,14 +27,55 @@
 #ifndef EDGEDETECT_H
 #define EDGEDETECT_H
 
-class QImage;
+#include "imagefilter.h"
+
+class QPoint;
+class QSize;
 
 namespace MEMS {
 
-extern QImage sobelOperator(const QImage& image);
-extern QImage prewittOperator(const QImage& image);
-extern QImage scharrOperator(const QImage& image);
+constexpr FixedKernel<3,3> SobelKernelX = {{{-1, 0, 1},
+                                            {-2, 0, 2},
+                                            {-1, 0, 1}}};
+constexpr FixedKernel<3,3> SobelKernelY = {{{-1,-2,-1},
+                                            { 0, 0, 0},
+                                            { 1, 2, 1}}};
+constexpr FixedKernel<3,3> PrewittKernelX = {{{-1, 0, 1},
+                                              {-1, 0, 1},
+                                              {-1, 0, 1}}};
+constexpr FixedKernel<3,3> PrewittKernelY = {{{-1,-1,-1},
+                                              { 0, 0, 0},
+                                              { 1, 1, 1}}};
+constexpr FixedKernel<3,3> ScharrKernelX = {{{ -3, 0,  3},
+                                             {-10, 0, 10},
+                                             { -3, 0,  3}}};
+constexpr FixedKernel<3,3> ScharrKernelY = {{{ -3,-10, -3},
+                                             {  0,  0,  0},
+                                             {  3, 10,  3}}};
+constexpr FixedKernel<3,3> LaplacianKernel = {{{ 0, 1, 0},
+                                               { 1,-4, 1},
+                                               { 0, 1, 0}}};
+
+enum class GradientNorm
+{
+    Euclidean = 0,
+    Manhattan = 1,
+    Chebyshev = 2,
+};
+
+extern QImage sobelOperator(const QImage& image,
+                            GradientNorm norm = GradientNorm::Euclidean);
+extern QImage prewittOperator(const QImage& image,
+                              GradientNorm norm = GradientNorm::Euclidean);
+extern QImage scharrOperator(const QImage& image,
+                             GradientNorm norm = GradientNorm::Euclidean);
 extern QImage laplacianOperator(const QImage& image);
+extern QImage boundaryOperator(const QImage& image);
+extern QImage cannyOperator(const QImage& image, qreal lowThreshold, qreal highThreshold);
+
+extern QVector<QPoint> boundaryPoints(const QImage& image);
+extern QVector<QPoint> cannyPoints(const QImage& image, qreal lowThreshold, qreal highThreshold);
+extern QImage edgePointsImage(const QSize& size, const QVector<QPoint>& points);
 
 } // namespace MEMS
 
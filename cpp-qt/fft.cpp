@@ -0,0 +1,321 @@
+/**
+ ** MIT License
+ **
+ ** This file is part of the MEMS-oriented-image-testing-technology project.
+ ** Copyright (c) 2018 Lu <miroox@outlook.com>.
+ **
+ ** Permission is hereby granted, free of charge, to any person obtaining a copy
+ ** of this software and associated documentation files (the "Software"), to deal
+ ** in the Software without restriction, including without limitation the rights
+ ** to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ ** copies of the Software, and to permit persons to whom the Software is
+ ** furnished to do so, subject to the following conditions:
+ **
+ ** The above copyright notice and this permission notice shall be included in all
+ ** copies or substantial portions of the Software.
+ **
+ ** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ ** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ ** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ ** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ ** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM
+ ** OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ ** SOFTWARE.
+ **/
+
+/**
+ ** The factorization and the butterflies of FftPlan are derived from KISS FFT,
+ ** which is distributed under the following license.
+ **
+ ** Copyright (c) 2003-2010, Mark Borgerding
+ **
+ ** All rights reserved.
+ **
+ ** Redistribution and use in source and binary forms, with or without modification,
+ ** are permitted provided that the following conditions are met:
+ **
+ **     * Redistributions of source code must retain the above copyright notice,
+ **       this list of conditions and the following disclaimer.
+ **     * Redistributions in binary form must reproduce the above copyright notice,
+ **       this list of conditions and the following disclaimer in the documentation
+ **       and/or other materials provided with the distribution.
+ **     * Neither the author nor the names of any contributors may be used to endorse
+ **       or promote products derived from this software without specific prior written permission.
+ **
+ ** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ** ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ ** WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ ** IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ ** INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ ** BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ ** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ ** LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ ** OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ ** OF THE POSSIBILITY OF SUCH DAMAGE.
+ **/
+
+
+#include "fft.h"
+
+/*!
+    \headerfile <fft.h>
+    \title Fast Fourier Transform
+    \brief The <fft.h> header file provides a mixed-radix fast Fourier transform,
+    which the frequency-domain convolution is built on.
+
+    \sa <imagefilter.h>
+ */
+
+#include <QVarLengthArray>
+#include <cmath>
+#include <algorithm>
+
+namespace MEMS {
+
+/*!
+    \class FftPlan
+
+    \brief Precomputed factors and twiddles of the discrete Fourier transform of a fixed size.
+
+    The transform is a recursive mixed-radix Cooley-Tukey algorithm after KISS FFT, with specialized
+    butterflies for radix 2, 3, 4, and 5, and a generic one for the other prime factors.
+    It is fastest for sizes with only the factors 2, 3, and 5, see fastSize().
+
+    A plan is not modified by transforms, so one plan can be shared by many threads.
+ */
+
+/*!
+    Create a plan for the transforms of \a size points.
+ */
+FftPlan::FftPlan(int size)
+    : n(size), twiddles(size), inverseTwiddles(size)
+{
+    Q_ASSERT_X(size>0,__func__,"size of transform must be positive");
+
+    const qreal pi = ::std::acos(qreal(-1));
+    for (int i=0; i<n; ++i)
+    {
+        twiddles[i] = ::std::polar(qreal(1),-2*pi*i/n);
+        inverseTwiddles[i] = ::std::conj(twiddles.at(i));
+    }
+
+    // factor out 4 first, then 2, and then the odd numbers
+    const int floorSqrt = static_cast<int>(::std::floor(::std::sqrt(qreal(n))));
+    int p = 4;
+    int m = n;
+    do
+    {
+        while (m%p)
+        {
+            switch (p)
+            {
+            case 4:
+                p = 2;
+                break;
+            case 2:
+                p = 3;
+                break;
+            default:
+                p += 2;
+                break;
+            }
+            if (p > floorSqrt)
+                p = m;
+        }
+        m /= p;
+        factors << p << m;
+    } while (m > 1);
+}
+
+int FftPlan::size() const
+{
+    return n;
+}
+
+/*!
+    Returns the smallest size not less than \a minimum whose only prime factors are 2, 3, and 5.
+ */
+int FftPlan::fastSize(int minimum)
+{
+    for (int size=qMax(1,minimum); ; ++size)
+    {
+        int m = size;
+        for (const int p : {2,3,5})
+        {
+            while (m%p == 0)
+                m /= p;
+        }
+        if (m == 1)
+            return size;
+    }
+}
+
+/*!
+    Compute the forward transform X[k] = Σ x[j]*exp(-2πijk/n) of the size() points \a input,
+    which are \a inputStride apart, and store it to \a output. They must not overlap.
+ */
+void FftPlan::transform(const Complex* input, Complex* output, int inputStride) const
+{
+    Q_ASSERT(input!=output);
+    work(input,output,0,1,inputStride,false);
+}
+
+/*!
+    Compute the inverse transform x[j] = Σ X[k]*exp(2πijk/n)/n of the size() points \a input,
+    which are \a inputStride apart, and store it to \a output. They must not overlap.
+ */
+void FftPlan::inverseTransform(const Complex* input, Complex* output, int inputStride) const
+{
+    Q_ASSERT(input!=output);
+    work(input,output,0,1,inputStride,true);
+    const qreal scale = qreal(1)/n;
+    for (int i=0; i<n; ++i)
+    {
+        output[i] *= scale;
+    }
+}
+
+/*!
+    \internal
+
+    Complex multiplication without the checks for infinity and NaN
+    that \c{std::complex} performs, which would not be inlined.
+ */
+static inline Complex multiply(const Complex& a, const Complex& b)
+{
+    return Complex(a.real()*b.real()-a.imag()*b.imag(),
+                   a.real()*b.imag()+a.imag()*b.real());
+}
+
+/*!
+    \internal
+
+    Transform the sub-sequences of \a input by the factors from \a factorIndex on,
+    then combine the results with the butterflies of the radix at \a factorIndex.
+ */
+void FftPlan::work(const Complex* input, Complex* output, int factorIndex,
+                   int twiddleStride, int inputStride, bool inverse) const
+{
+    const int p = factors.at(factorIndex);
+    const int m = factors.at(factorIndex+1);
+    const Complex* const tw = inverse ? inverseTwiddles.constData() : twiddles.constData();
+
+    if (m == 1)
+    {
+        for (int q=0; q<p; ++q)
+        {
+            output[q] = input[q*twiddleStride*inputStride];
+        }
+    }
+    else
+    {
+        for (int q=0; q<p; ++q)
+        {
+            work(input+q*twiddleStride*inputStride,output+q*m,factorIndex+2,
+                 twiddleStride*p,inputStride,inverse);
+        }
+    }
+
+    switch (p)
+    {
+    case 2:
+        for (int k=0; k<m; ++k)
+        {
+            const Complex t = multiply(output[k+m],tw[k*twiddleStride]);
+            output[k+m] = output[k]-t;
+            output[k] += t;
+        }
+        break;
+    case 3:
+    {
+        const qreal sine = tw[twiddleStride*m].imag();
+        for (int k=0; k<m; ++k)
+        {
+            const Complex s1 = multiply(output[k+m],tw[k*twiddleStride]);
+            const Complex s2 = multiply(output[k+2*m],tw[2*k*twiddleStride]);
+            const Complex sum = s1+s2;
+            const Complex difference = (s1-s2)*sine;
+            const Complex t = output[k]-sum*qreal(0.5);
+            output[k] += sum;
+            output[k+m] = Complex(t.real()-difference.imag(),t.imag()+difference.real());
+            output[k+2*m] = Complex(t.real()+difference.imag(),t.imag()-difference.real());
+        }
+        break;
+    }
+    case 4:
+        for (int k=0; k<m; ++k)
+        {
+            const Complex s0 = multiply(output[k+m],tw[k*twiddleStride]);
+            const Complex s1 = multiply(output[k+2*m],tw[2*k*twiddleStride]);
+            const Complex s2 = multiply(output[k+3*m],tw[3*k*twiddleStride]);
+            const Complex s3 = s0+s2;
+            // multiplied by -i, or i for the inverse transform
+            const Complex s4 = inverse ? Complex(-(s0-s2).imag(),(s0-s2).real())
+                                       : Complex((s0-s2).imag(),-(s0-s2).real());
+            const Complex s5 = output[k]-s1;
+            output[k] += s1;
+            output[k+2*m] = output[k]-s3;
+            output[k] += s3;
+            output[k+m] = s5+s4;
+            output[k+3*m] = s5-s4;
+        }
+        break;
+    case 5:
+    {
+        const Complex ya = tw[twiddleStride*m];
+        const Complex yb = tw[2*twiddleStride*m];
+        for (int k=0; k<m; ++k)
+        {
+            const Complex s0 = output[k];
+            const Complex s1 = multiply(output[k+m],tw[k*twiddleStride]);
+            const Complex s2 = multiply(output[k+2*m],tw[2*k*twiddleStride]);
+            const Complex s3 = multiply(output[k+3*m],tw[3*k*twiddleStride]);
+            const Complex s4 = multiply(output[k+4*m],tw[4*k*twiddleStride]);
+            const Complex s7 = s1+s4;
+            const Complex s8 = s2+s3;
+            const Complex s9 = s2-s3;
+            const Complex s10 = s1-s4;
+            output[k] += s7+s8;
+            const Complex s5 = s0+s7*ya.real()+s8*yb.real();
+            const Complex s6(s10.imag()*ya.imag()+s9.imag()*yb.imag(),
+                             -s10.real()*ya.imag()-s9.real()*yb.imag());
+            output[k+m] = s5-s6;
+            output[k+4*m] = s5+s6;
+            const Complex s11 = s0+s7*yb.real()+s8*ya.real();
+            const Complex s12(-s10.imag()*yb.imag()+s9.imag()*ya.imag(),
+                              s10.real()*yb.imag()-s9.real()*ya.imag());
+            output[k+2*m] = s11+s12;
+            output[k+3*m] = s11-s12;
+        }
+        break;
+    }
+    default:
+    {
+        QVarLengthArray<Complex,16> scratch(p);
+        for (int k=0; k<m; ++k)
+        {
+            for (int q=0; q<p; ++q)
+            {
+                scratch[q] = output[k+q*m];
+            }
+            for (int q=0; q<p; ++q)
+            {
+                const int index = k+q*m;
+                Complex sum = scratch[0];
+                int twiddleIndex = 0;
+                for (int r=1; r<p; ++r)
+                {
+                    twiddleIndex += twiddleStride*index;
+                    if (twiddleIndex >= n)
+                        twiddleIndex %= n;
+                    sum += multiply(scratch[r],tw[twiddleIndex]);
+                }
+                output[index] = sum;
+            }
+        }
+        break;
+    }
+    }
+}
+
+} // namespace MEMS
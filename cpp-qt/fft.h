@@ -0,0 +1,61 @@
+/**
+ ** MIT License
+ **
+ ** This file is part of the MEMS-oriented-image-testing-technology project.
+ ** Copyright (c) 2018 Lu <miroox@outlook.com>.
+ **
+ ** Permission is hereby granted, free of charge, to any person obtaining a copy
+ ** of this software and associated documentation files (the "Software"), to deal
+ ** in the Software without restriction, including without limitation the rights
+ ** to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ ** copies of the Software, and to permit persons to whom the Software is
+ ** furnished to do so, subject to the following conditions:
+ **
+ ** The above copyright notice and this permission notice shall be included in all
+ ** copies or substantial portions of the Software.
+ **
+ ** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ ** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ ** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ ** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ ** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM
+ ** OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ ** SOFTWARE.
+ **/
+
+
+#ifndef FFT_H
+#define FFT_H
+
+#include <QVector>
+#include <complex>
+
+namespace MEMS {
+
+using Complex = ::std::complex<qreal>;
+
+class FftPlan
+{
+public:
+    FftPlan() = default;
+    explicit FftPlan(int size);
+
+    int size() const;
+    void transform(const Complex* input, Complex* output, int inputStride = 1) const;
+    void inverseTransform(const Complex* input, Complex* output, int inputStride = 1) const;
+
+    static int fastSize(int minimum);
+
+private:
+    void work(const Complex* input, Complex* output, int factorIndex,
+              int twiddleStride, int inputStride, bool inverse) const;
+
+    int n = 0;
+    QVector<int> factors;
+    QVector<Complex> twiddles;
+    QVector<Complex> inverseTwiddles;
+};
+
+} // namespace MEMS
+
+#endif // FFT_H
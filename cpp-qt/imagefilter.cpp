@@ -34,9 +34,19 @@
 
 #include <QImage>
 #include <QPoint>
+#include <QSize>
 #include <QColor>
+#include <QCache>
+#include <QList>
+#include <QMutex>
+#include <QPair>
 #include <cmath>
+#include <limits>
 #include <algorithm>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "fft.h"
 #include "utils.h"
 
 namespace MEMS {
@@ -45,6 +55,26 @@ namespace MEMS {
     \class MatrixKernel
 
     \brief Type of kernel for convolution.
+
+    The elements are stored in a single contiguous array, so that looking up
+    an element costs one multiplication and no extra indirection.
+ */
+
+/*!
+    \class FixedKernel
+
+    \brief Kernel of compile-time size \c Rows x \c Columns for convolution.
+
+    It is a literal type, so a kernel of constant coefficients can be built at compile time:
+
+    \code
+    constexpr FixedKernel<3,3> kernel = {{{0,1,0},{1,-4,1},{0,1,0}}};
+    \endcode
+
+    The size is known to convolve(), so its loops over the taps can be unrolled and vectorized.
+    It converts implicitly to MatrixKernel for the other functions.
+
+    \sa MatrixKernel
  */
 
 /*!
@@ -66,86 +96,146 @@ namespace MEMS {
  */
 
 MatrixKernel::MatrixKernel(const MatrixKernel& other)
-    : data(other.data)
+    : kerRows(other.kerRows), kerCols(other.kerCols), data(other.data)
 {
 }
 
 MatrixKernel::MatrixKernel(int rows, int columns, qreal value)
-    : data(rows, QVector<qreal>(columns,value))
+    : kerRows(rows), kerCols(columns), data(rows*columns,value)
 {
 }
 
 MatrixKernel::MatrixKernel(const QVector<QVector<qreal>>& args)
-    : data(args)
+    : kerRows(args.size()), kerCols(args.isEmpty() ? 0 : args.first().size())
 {
-    const int cols = columns();
-    for (const auto& row : data)
+    data.reserve(kerRows*kerCols);
+    for (const auto& row : args)
     {
-        Q_ASSERT_X(row.size()==cols,__func__,"Kernel is not a matrix");
+        Q_ASSERT_X(row.size()==kerCols,__func__,"Kernel is not a matrix");
+        data += row;
     }
 }
 
 MatrixKernel::MatrixKernel(QVector<QVector<qreal>>&& args)
-    : data(args)
+    : MatrixKernel(static_cast<const QVector<QVector<qreal>>&>(args))
 {
-    const int cols = columns();
-    for (const auto& row : data)
-    {
-        Q_ASSERT_X(row.size()==cols,__func__,"Kernel is not a matrix");
-    }
 }
 
-int MatrixKernel::rows() const
-{
-    return data.size();
-}
+/*!
+    \fn const qreal* MatrixKernel::constData() const
 
-int MatrixKernel::columns() const
-{
-    return data.first().size();
-}
+    Returns a pointer to the elements, which are stored contiguously
+    in row-major order, i.e. the element at \c row and \c column is
+    \c{constData()[row*columns()+column]}.
+ */
+
+/*!
+    Returns \c true if the kernel is the outer product of a column vector
+    and a row vector, i.e. its rank is 1.
 
-qreal MatrixKernel::at(int row, int column) const
+    \sa separate()
+ */
+bool MatrixKernel::isSeparable() const
 {
-    return data.at(row).at(column);
+    return separate(nullptr,nullptr);
 }
 
-qreal &MatrixKernel::operator()(int row, int column)
+/*!
+    Decompose the kernel into a \a column kernel and a \a row kernel,
+    whose outer product is the kernel itself.
+
+    Returns \c false and leaves \a column and \a row untouched if the kernel is not separable.
+
+    \sa convolveSeparable()
+ */
+bool MatrixKernel::separate(MatrixKernel* column, MatrixKernel* row) const
 {
-    return data[row][column];
+    using ::std::abs;
+
+    const int kerRows = rows();
+    const int kerCols = columns();
+
+    // use the element of the largest magnitude as pivot
+    int pivotRow = 0, pivotCol = 0;
+    for (int i=0; i<kerRows; ++i)
+    {
+        for (int j=0; j<kerCols; ++j)
+        {
+            if (abs(at(i,j)) > abs(at(pivotRow,pivotCol)))
+            {
+                pivotRow = i;
+                pivotCol = j;
+            }
+        }
+    }
+    const qreal pivot = at(pivotRow,pivotCol);
+    if (qFuzzyIsNull(pivot))
+        return false;
+
+    MatrixKernel col(kerRows,1);
+    MatrixKernel r(1,kerCols);
+    for (int i=0; i<kerRows; ++i)
+        col(i,0) = at(i,pivotCol);
+    for (int j=0; j<kerCols; ++j)
+        r(0,j) = at(pivotRow,j)/pivot;
+
+    const qreal tolerance = 1e-9*abs(pivot);
+    for (int i=0; i<kerRows; ++i)
+    {
+        for (int j=0; j<kerCols; ++j)
+        {
+            if (abs(at(i,j)-col.at(i,0)*r.at(0,j)) > tolerance)
+                return false;
+        }
+    }
+
+    if (column)
+        *column = col;
+    if (row)
+        *row = r;
+    return true;
 }
 
-qreal MatrixKernel::operator()(int row, int column) const
+/*!
+    Returns the transpose of the kernel.
+ */
+MatrixKernel MatrixKernel::transposed() const
 {
-    return data[row][column];
+    const int kerRows = rows();
+    const int kerCols = columns();
+    MatrixKernel mat(kerCols,kerRows);
+    for (int i=0; i<kerRows; ++i)
+    {
+        for (int j=0; j<kerCols; ++j)
+        {
+            mat(j,i) = at(i,j);
+        }
+    }
+    return mat;
 }
 
 MatrixKernel& MatrixKernel::operator =(const MatrixKernel& other)
 {
+    kerRows = other.kerRows;
+    kerCols = other.kerCols;
     data = other.data;
     return *this;
 }
 
 MatrixKernel& MatrixKernel::operator *=(qreal scaler)
 {
-    for (auto& row : data)
+    for (auto& val : data)
     {
-        for (auto& val : row)
-        {
-            val *= scaler;
-        }
+        val *= scaler;
     }
     return *this;
 }
 
 MatrixKernel& MatrixKernel::operator /=(qreal scaler)
 {
-    for (auto& row : data)
+    for (auto& val : data)
     {
-        for (auto& val : row)
-        {
-            val /= scaler;
-        }
+        val /= scaler;
     }
     return *this;
 }
@@ -164,6 +254,153 @@ MatrixKernel MatrixKernel::operator /(qreal scaler) const
     return mat;
 }
 
+/*!
+    Quantize the kernel to fixed-point weights with \a fractionBits fractional bits.
+
+    \sa QuantizedKernel
+ */
+QuantizedKernel MatrixKernel::quantized(int fractionBits) const
+{
+    return QuantizedKernel(*this,fractionBits);
+}
+
+/*!
+    \class QuantizedKernel
+
+    \brief Kernel of fixed-point integer weights for convolution.
+
+    Each weight is rounded to the nearest multiple of 2^-fractionBits(), so an 8-bit
+    image can be convolved with integer arithmetic only. A separable kernel is quantized
+    as its column and row factors.
+
+    The result differs from the floating-point convolve() by at most
+    ceil(maxError()) levels in each channel. With the default 16 fractional bits,
+    maxError() is below 255*n*2^-17 for a kernel of n weights (e.g. 0.05 for 5x5),
+    so the output is the same or off by one level where the exact value is within
+    maxError() of an integer.
+
+    \sa MatrixKernel::quantized()
+ */
+
+/*!
+    \internal
+ */
+static inline qint32 quantize(qreal value, int fractionBits)
+{
+    return static_cast<qint32>(::std::lround(::std::ldexp(value,fractionBits)));
+}
+
+/*!
+    Quantize \a kernel with \a fractionBits fractional bits.
+
+    The sum of absolute weights must be less than 2^(23-fractionBits),
+    so the accumulator of 8-bit samples does not overflow.
+
+    For a separable kernel, the horizontal pass is rounded to fewer bits if needed,
+    so that the vertical pass fits in 32-bit integers too. maxError() includes the
+    rounding error.
+ */
+QuantizedKernel::QuantizedKernel(const MatrixKernel& kernel, int fractionBits)
+    : kerRows(kernel.rows()),
+      kerCols(kernel.columns()),
+      bits(fractionBits),
+      weights(kerRows*kerCols)
+{
+    using ::std::abs;
+    using ::std::ldexp;
+
+    Q_ASSERT_X(fractionBits>=0 && fractionBits<=23,__func__,"fraction bits is out of range");
+    Q_ASSUME(kerRows%2==1);
+    Q_ASSUME(kerCols%2==1);
+
+    MatrixKernel column, row;
+    if (kerRows>1 && kerCols>1 && kernel.separate(&column,&row))
+    {
+        columnWeights.resize(kerRows);
+        rowWeights.resize(kerCols);
+        for (int i=0; i<kerRows; ++i)
+            columnWeights[i] = quantize(column.at(i,0),bits);
+        for (int j=0; j<kerCols; ++j)
+            rowWeights[j] = quantize(row.at(0,j),bits);
+    }
+
+    for (int i=0; i<kerRows; ++i)
+    {
+        for (int j=0; j<kerCols; ++j)
+        {
+            weights[i*kerCols+j] = quantize(kernel.at(i,j),bits);
+            error += abs(at(i,j)-kernel.at(i,j));
+        }
+    }
+    error *= 0xff;
+
+    // the magnitude of the 32-bit accumulator (the horizontal pass if separable)
+    qint64 magnitude = 0;
+    for (const qint32 w : isSeparable() ? rowWeights : weights)
+        magnitude += abs(w);
+    magnitude *= 0xff;
+    Q_ASSERT_X(magnitude<=::std::numeric_limits<qint32>::max(),__func__,"Kernel is too large to quantize");
+
+    if (isSeparable())
+    {
+        // round the horizontal pass so that the vertical pass fits in 32-bit as well
+        qint64 columnMagnitude = 0;
+        for (const qint32 w : qAsConst(columnWeights))
+            columnMagnitude += abs(w);
+        while (columnMagnitude*((magnitude>>intermediateShift)+1) > ::std::numeric_limits<qint32>::max())
+            ++intermediateShift;
+        if (intermediateShift>0)
+            error += ldexp(qreal(columnMagnitude),intermediateShift-1-2*bits);
+    }
+}
+
+int QuantizedKernel::rows() const
+{
+    return kerRows;
+}
+
+int QuantizedKernel::columns() const
+{
+    return kerCols;
+}
+
+int QuantizedKernel::fractionBits() const
+{
+    return bits;
+}
+
+/*!
+    Returns \c true if the kernel is quantized as separate column and row factors.
+
+    \sa MatrixKernel::separate()
+ */
+bool QuantizedKernel::isSeparable() const
+{
+    return !rowWeights.isEmpty();
+}
+
+/*!
+    Returns the effective weight at \a row and \a column, i.e. the weight
+    that convolve() actually applies after quantization.
+ */
+qreal QuantizedKernel::at(int row, int column) const
+{
+    using ::std::ldexp;
+
+    if (isSeparable())
+        return ldexp(qreal(columnWeights.at(row))*rowWeights.at(column),-2*bits);
+    return ldexp(qreal(weights.at(row*kerCols+column)),-bits);
+}
+
+/*!
+    Returns the upper bound of the difference between convolve() with this kernel
+    and the exact convolution with the original kernel, in levels of an 8-bit channel.
+ */
+qreal QuantizedKernel::maxError() const
+{
+    return error;
+}
+
 /*!
     \internal
  */
@@ -179,16 +416,17 @@ static inline int calcPaddingX(const int width, int x, PaddingType padding)
         break;
     case PaddingType::Periodic:
         x = x>=0 ? x%width
-                 : x%width+width;
+                 : (x%width+width)%width;
         break;
     case PaddingType::Reflected:
-        while (x>=0 && x<width)
+        while (x<0 || x>=width)
         {
             if (x<0)
                 x = -x-1;
             else
                 x = 2*width-x-1;
         }
+        break;
     default:
         Q_UNREACHABLE();
         break;
@@ -198,286 +436,1702 @@ static inline int calcPaddingX(const int width, int x, PaddingType padding)
 
 /*!
     \internal
+
+    Precalculate the source index of every position in [-radius, size+radius)
+    for the \a padding, so the convolutions need not call calcPaddingX() per tap.
  */
-static inline int calcPaddingY(const int height, int y, PaddingType padding)
+static QVector<int> paddingIndices(const int size, int radius, PaddingType padding)
 {
-    switch (padding)
+    QVector<int> indices(size+2*radius);
+    for (int i=0; i<indices.size(); ++i)
     {
-    case PaddingType::Fixed:
-        if (y<0)
-            y = 0;
-        else if (y>=height)
-            y = height-1;
-        break;
-    case PaddingType::Periodic:
-        y = y>=0 ? y%height
-                 : y%height+height;
-        break;
-    case PaddingType::Reflected:
-        while (y>=0 && y<height)
-        {
-            if (y<0)
-                y = -y-1;
-            else
-                y = 2*height-y-1;
-        }
-        break;
-    default:
-        Q_UNREACHABLE();
-        break;
+        indices[i] = calcPaddingX(size,i-radius,padding);
     }
-    return y;
+    return indices;
 }
 
 /*!
-    Convolve the \a image with \a kernel, using specified padding type \a padding
+    \internal
+
+    Pixel layout of the working image of the filters.
+
+    Grayscale images are processed natively in a single 8-bit channel (\c uchar),
+    and other images in the three channels of RGB32 (\c QRgb).
  */
-QImage convolve(const QImage& image, const MatrixKernel& kernel, PaddingType padding)
-{
-    QImage output(image.size(),QImage::Format_RGB32);
-    const QImage input = image.convertToFormat(QImage::Format_RGB32);
+template<typename Pixel>
+struct PixelTraits;
 
-    const int width = image.width();
-    const int height = image.height();
-    const int kerRows = kernel.rows();
-    const int kerCols = kernel.columns();
-    Q_ASSUME(kerRows%2==1);
-    Q_ASSUME(kerCols%2==1);
-    const int kerCenterX = kerCols/2;
-    const int kerCenterY = kerRows/2;
+template<>
+struct PixelTraits<QRgb>
+{
+    enum { Channels = 3 };
 
-    for (int y=0; y<height; ++y)
+    static QImage::Format format()
     {
-        QRgb* line = reinterpret_cast<QRgb*>(output.scanLine(y));
-        for (int x=0; x<width; ++x)
-        {
-            qreal rr=0, gg=0, bb=0;
-            for (int i=0; i<kerRows; ++i)
-            {
-                const int yy = calcPaddingY(height,y+i-kerCenterY,padding);
-                const QRgb* iLine = reinterpret_cast<const QRgb*>(input.constScanLine(yy));
-                for (int j=0; j<kerCols; ++j)
-                {
-                    MAYBE_INTERRUPT();
+        return QImage::Format_RGB32;
+    }
+    static int channel(QRgb pixel, int c)
+    {
+        // red, green, and blue
+        return (pixel >> (16-8*c)) & 0xff;
+    }
+    static QRgb pixel(const int* channels)
+    {
+        return qRgb(channels[0],channels[1],channels[2]);
+    }
+};
 
-                    const int xx = calcPaddingX(width,x+j-kerCenterX,padding);
-                    const auto kerVar = kernel.at(kerRows-1-i,kerCols-1-j);
-                    rr += qRed(iLine[xx])*kerVar;
-                    gg += qGreen(iLine[xx])*kerVar;
-                    bb += qBlue(iLine[xx])*kerVar;
-                }
-            }
-            line[x] = qRgb(qBound(0,static_cast<int>(rr),0xff),
-                           qBound(0,static_cast<int>(gg),0xff),
-                           qBound(0,static_cast<int>(bb),0xff));
-        }
+template<>
+struct PixelTraits<uchar>
+{
+    enum { Channels = 1 };
 
-        PROGRESS_UPDATE(y/height);
+    static QImage::Format format()
+    {
+        return QImage::Format_Grayscale8;
+    }
+    static int channel(uchar pixel, int)
+    {
+        return pixel;
+    }
+    static uchar pixel(const int* channels)
+    {
+        return static_cast<uchar>(channels[0]);
     }
+};
 
-    return output.convertToFormat(image.format());
+/*!
+    \internal
+
+    Flip a row or column \a kernel into a list of taps in convolution order.
+ */
+static QVector<qreal> separableTaps(const MatrixKernel& kernel)
+{
+    const int length = kernel.rows()*kernel.columns();
+    Q_ASSUME(kernel.rows()==1 || kernel.columns()==1);
+    Q_ASSUME(length%2==1);
+    QVector<qreal> taps(length);
+    for (int k=0; k<length; ++k)
+    {
+        taps[k] = kernel.rows()==1 ? kernel.at(0,length-1-k)
+                                   : kernel.at(length-1-k,0);
+    }
+    return taps;
 }
 
 /*!
-    \overload convolve
+    \internal
 
-    Convolve the \a image with \a kernel, using specified padding color \a padding
+    The horizontal pass: convolve an extended (padded) line \a extLine of \a width + taps - 1 pixels,
+    and store the result of each channel to \a out.
  */
-QImage convolve(const QImage& image, const MatrixKernel& kernel, QRgb padding)
+template<typename Pixel>
+static void convolveRowPass(const Pixel* extLine, const int width, const QVector<qreal>& taps, qreal* out)
 {
-    QImage output(image.size(),QImage::Format_RGB32);
-
-    const int width = image.width();
-    const int height = image.height();
-    const int kerRows = kernel.rows();
-    const int kerCols = kernel.columns();
-    Q_ASSUME(kerRows%2==1);
-    Q_ASSUME(kerCols%2==1);
-    const int kerCenterX = kerCols/2;
-    const int kerCenterY = kerRows/2;
+    using Traits = PixelTraits<Pixel>;
 
-    for (int y=0; y<height; ++y)
+    const int length = taps.size();
+    const qreal* k = taps.constData();
+    for (int x=0; x<width; ++x)
     {
-        QRgb* line = reinterpret_cast<QRgb*>(output.scanLine(y));
-        for (int x=0; x<width; ++x)
+        qreal sum[Traits::Channels] = {};
+        for (int j=0; j<length; ++j)
         {
-            qreal rr=0, gg=0, bb=0;
-            for (int i=0; i<kerRows; ++i)
+            for (int c=0; c<Traits::Channels; ++c)
             {
-                for (int j=0; j<kerCols; ++j)
-                {
-                    MAYBE_INTERRUPT();
-
-                    const QRgb pix = image.valid(x+j-kerCenterX,y+i-kerCenterY)
-                                    ? image.pixel(x+j-kerCenterX,y+i-kerCenterY)
-                                    : padding;
-                    const auto kerVar = kernel.at(kerRows-1-i,kerCols-1-j);
-                    rr += qRed(pix)*kerVar;
-                    gg += qGreen(pix)*kerVar;
-                    bb += qBlue(pix)*kerVar;
-                }
+                sum[c] += Traits::channel(extLine[x+j],c)*k[j];
             }
-            line[x] = qRgb(qBound(0,static_cast<int>(rr),0xff),
-                           qBound(0,static_cast<int>(gg),0xff),
-                           qBound(0,static_cast<int>(bb),0xff));
         }
-
-        PROGRESS_UPDATE(y/height);
+        for (int c=0; c<Traits::Channels; ++c)
+        {
+            out[Traits::Channels*x+c] = sum[c];
+        }
     }
-
-    return output.convertToFormat(image.format());
 }
 
 /*!
-    \overload convolve
+    \internal
 
-    Convolve the \a image with \a kernel, using specified padding color \a padding
+    The vertical pass: combine the rows \a rows (one for each tap) of the horizontal pass,
+    and write the result to \a line of the output image.
  */
-QImage convolve(const QImage& image, const MatrixKernel& kernel, const QColor& padding)
+template<typename Pixel>
+static void convolveColumnPass(const qreal* const* rows, const int width, const QVector<qreal>& taps,
+                               qreal* accumulator, Pixel* line)
 {
-    return convolve(image,kernel,padding.rgb());
+    using Traits = PixelTraits<Pixel>;
+
+    const int length = taps.size();
+    const int count = Traits::Channels*width;
+    ::std::fill(accumulator,accumulator+count,qreal(0));
+    for (int i=0; i<length; ++i)
+    {
+        const qreal k = taps.at(i);
+        const qreal* row = rows[i];
+        for (int c=0; c<count; ++c)
+        {
+            accumulator[c] += row[c]*k;
+        }
+    }
+    for (int x=0; x<width; ++x)
+    {
+        int channels[Traits::Channels];
+        for (int c=0; c<Traits::Channels; ++c)
+        {
+            channels[c] = qBound(0,static_cast<int>(accumulator[Traits::Channels*x+c]),0xff);
+        }
+        line[x] = Traits::pixel(channels);
+    }
 }
 
 /*!
-    Convolve the \a image with kernel \a kerX & \b kerY, using specified padding type \a padding,
-    and then combine the two.
+    \internal
  */
-QImage convolveXY(const QImage& image, const MatrixKernel& kerX, const MatrixKernel& kerY, PaddingType padding)
+template<typename Pixel>
+static QImage convolveSeparable_Impl(const QImage& image, const MatrixKernel& column, const MatrixKernel& row,
+                                     PaddingType padding)
 {
-    using ::std::hypot;
+    using Traits = PixelTraits<Pixel>;
 
-    QImage output(image.size(),QImage::Format_RGB32);
-    const QImage input = image.convertToFormat(QImage::Format_RGB32);
+    Q_ASSUME(column.columns()==1);
+    Q_ASSUME(row.rows()==1);
+
+    QImage output(image.size(),Traits::format());
+    const QImage input = image.convertToFormat(Traits::format());
 
     const int width = image.width();
     const int height = image.height();
-    Q_ASSUME(kerX.rows()==kerY.rows());
-    Q_ASSUME(kerX.columns()==kerY.columns());
-    const int kerRows = kerX.rows();
-    const int kerCols = kerX.columns();
-    Q_ASSUME(kerRows%2==1);
-    Q_ASSUME(kerCols%2==1);
-    const int kerCenterX = kerCols/2;
-    const int kerCenterY = kerRows/2;
-
-    for (int y=0; y<height; ++y)
-    {
-        QRgb* line = reinterpret_cast<QRgb*>(output.scanLine(y));
-        for (int x=0; x<width; ++x)
+    const int count = Traits::Channels*width;
+    const QVector<qreal> tapsX = separableTaps(row);
+    const QVector<qreal> tapsY = separableTaps(column);
+    const int kerCenterX = tapsX.size()/2;
+    const int kerCenterY = tapsY.size()/2;
+    const QVector<int> indicesX = paddingIndices(width,kerCenterX,padding);
+    const QVector<int> indicesY = paddingIndices(height,kerCenterY,padding);
+
+    QVector<qreal> buffer(count*height);
+    parallelForRows(height,input.bytesPerLine(),[&](int begin, int end){
+        QVector<Pixel> extLine(width+2*kerCenterX);
+        for (int y=begin; y<end; ++y)
         {
-            qreal rx=0, gx=0, bx=0;
-            qreal ry=0, gy=0, by=0;
-            for (int i=0; i<kerRows; ++i)
+            const Pixel* iLine = reinterpret_cast<const Pixel*>(input.constScanLine(y));
+            for (int x=0; x<extLine.size(); ++x)
             {
-                const int yy = calcPaddingY(height,y+i-kerCenterY,padding);
-                const QRgb* iLine = reinterpret_cast<const QRgb*>(input.constScanLine(yy));
-                for (int j=0; j<kerCols; ++j)
-                {
-                    MAYBE_INTERRUPT();
-
-                    const int xx = calcPaddingX(width,x+j-kerCenterX,padding);
-                    const auto kerXVar = kerX.at(kerRows-1-i,kerCols-1-j);
-                    const auto kerYVar = kerY.at(kerRows-1-i,kerCols-1-j);
-                    rx += qRed(iLine[xx])*kerXVar;
-                    gx += qGreen(iLine[xx])*kerXVar;
-                    bx += qBlue(iLine[xx])*kerXVar;
-                    ry += qRed(iLine[xx])*kerYVar;
-                    gy += qGreen(iLine[xx])*kerYVar;
-                    by += qBlue(iLine[xx])*kerYVar;
-                }
+                extLine[x] = iLine[indicesX.at(x)];
             }
-            line[x] = qRgb(qBound(0,static_cast<int>(hypot(rx,ry)),0xff),
-                           qBound(0,static_cast<int>(hypot(gx,gy)),0xff),
-                           qBound(0,static_cast<int>(hypot(bx,by)),0xff));
+            convolveRowPass(extLine.constData(),width,tapsX,buffer.data()+count*y);
         }
-
-        PROGRESS_UPDATE(y/height);
-    }
+    },0,0.5);
+    MAYBE_INTERRUPT();
+
+    uchar* const outputBits = output.bits();
+    const int outputStride = output.bytesPerLine();
+    parallelForRows(height,count*sizeof(qreal),[&](int begin, int end){
+        QVector<const qreal*> rows(tapsY.size());
+        QVector<qreal> accumulator(count);
+        for (int y=begin; y<end; ++y)
+        {
+            for (int i=0; i<rows.size(); ++i)
+            {
+                rows[i] = buffer.constData()+count*indicesY.at(y+i);
+            }
+            convolveColumnPass(rows.constData(),width,tapsY,accumulator.data(),
+                               reinterpret_cast<Pixel*>(outputBits+y*outputStride));
+        }
+    },0.5,1);
+    MAYBE_INTERRUPT();
 
     return output.convertToFormat(image.format());
 }
 
 /*!
-    \overload convolveXY
-
-    Convolve the \a image with kernel \a kerX & \b kerY, using specified padding color \a padding,
-    and then combine the two.
+    \internal
  */
-QImage convolveXY(const QImage& image, const MatrixKernel& kerX, const MatrixKernel& kerY, QRgb padding)
+template<typename Pixel>
+static QImage convolveSeparable_Impl(const QImage& image, const MatrixKernel& column, const MatrixKernel& row,
+                                     Pixel padding)
 {
-    using ::std::hypot;
+    using Traits = PixelTraits<Pixel>;
 
-    QImage output(image.size(),QImage::Format_RGB32);
+    Q_ASSUME(column.columns()==1);
+    Q_ASSUME(row.rows()==1);
+
+    QImage output(image.size(),Traits::format());
+    const QImage input = image.convertToFormat(Traits::format());
 
     const int width = image.width();
     const int height = image.height();
-    Q_ASSUME(kerX.rows()==kerY.rows());
-    Q_ASSUME(kerX.columns()==kerY.columns());
+    const int count = Traits::Channels*width;
+    const QVector<qreal> tapsX = separableTaps(row);
+    const QVector<qreal> tapsY = separableTaps(column);
+    const int kerCenterX = tapsX.size()/2;
+    const int kerCenterY = tapsY.size()/2;
+
+    QVector<qreal> buffer(count*height);
+    parallelForRows(height,input.bytesPerLine(),[&](int begin, int end){
+        QVector<Pixel> extLine(width+2*kerCenterX,padding);
+        for (int y=begin; y<end; ++y)
+        {
+            const Pixel* iLine = reinterpret_cast<const Pixel*>(input.constScanLine(y));
+            ::std::copy(iLine,iLine+width,extLine.begin()+kerCenterX);
+            convolveRowPass(extLine.constData(),width,tapsX,buffer.data()+count*y);
+        }
+    },0,0.5);
+    MAYBE_INTERRUPT();
+
+    // the rows beyond the image are filled with padding color entirely
+    QVector<qreal> paddingRow(count);
+    const QVector<Pixel> paddingLine(width+2*kerCenterX,padding);
+    convolveRowPass(paddingLine.constData(),width,tapsX,paddingRow.data());
+
+    uchar* const outputBits = output.bits();
+    const int outputStride = output.bytesPerLine();
+    parallelForRows(height,count*sizeof(qreal),[&](int begin, int end){
+        QVector<const qreal*> rows(tapsY.size());
+        QVector<qreal> accumulator(count);
+        for (int y=begin; y<end; ++y)
+        {
+            for (int i=0; i<rows.size(); ++i)
+            {
+                const int yy = y+i-kerCenterY;
+                rows[i] = yy>=0 && yy<height ? buffer.constData()+count*yy
+                                             : paddingRow.constData();
+            }
+            convolveColumnPass(rows.constData(),width,tapsY,accumulator.data(),
+                               reinterpret_cast<Pixel*>(outputBits+y*outputStride));
+        }
+    },0.5,1);
+    MAYBE_INTERRUPT();
+
+    return output.convertToFormat(image.format());
+}
+
+/*!
+    Convolve the \a image with the separable kernel which is the outer product of
+    \a column and \a row, using specified padding type \a padding.
+
+    The image is convolved with \a row first and then with \a column,
+    so the cost per pixel is linear in the kernel radius.
+
+    \sa MatrixKernel::separate()
+ */
+QImage convolveSeparable(const QImage& image, const MatrixKernel& column, const MatrixKernel& row, PaddingType padding)
+{
+    return image.allGray() ? convolveSeparable_Impl<uchar>(image,column,row,padding)
+                           : convolveSeparable_Impl<QRgb>(image,column,row,padding);
+}
+
+/*!
+    \overload convolveSeparable
+
+    Convolve the \a image with the separable kernel which is the outer product of
+    \a column and \a row, using specified padding color \a padding
+ */
+QImage convolveSeparable(const QImage& image, const MatrixKernel& column, const MatrixKernel& row, QRgb padding)
+{
+    return image.allGray() && qIsGray(padding)
+            ? convolveSeparable_Impl<uchar>(image,column,row,static_cast<uchar>(qGray(padding)))
+            : convolveSeparable_Impl<QRgb>(image,column,row,padding);
+}
+
+/*!
+    \overload convolveSeparable
+
+    Convolve the \a image with the separable kernel which is the outer product of
+    \a column and \a row, using specified padding color \a padding
+ */
+QImage convolveSeparable(const QImage& image, const MatrixKernel& column, const MatrixKernel& row, const QColor& padding)
+{
+    return convolveSeparable(image,column,row,padding.rgb());
+}
+
+/*!
+    \internal
+
+    Flip the \a kernel into a list of taps in convolution order, row by row.
+ */
+static QVector<qreal> kernelTaps(const MatrixKernel& kernel)
+{
+    const int kerRows = kernel.rows();
+    const int kerCols = kernel.columns();
+    QVector<qreal> taps(kerRows*kerCols);
+    for (int i=0; i<kerRows; ++i)
+    {
+        for (int j=0; j<kerCols; ++j)
+        {
+            taps[i*kerCols+j] = kernel.at(kerRows-1-i,kerCols-1-j);
+        }
+    }
+    return taps;
+}
+
+/*!
+    \internal
+
+    Convolve one pixel with \a taps of \a kerRows x \a kerCols,
+    where \c fetch(i,j) returns the pixel under the tap at row \c i and column \c j.
+
+    Nonzero \c Rows and \c Columns fix the size at compile time, so the loops can be unrolled.
+ */
+template<typename Pixel, int Rows, int Columns, typename Fetch>
+static inline Pixel convolvePixel(const qreal* taps, int kerRows, int kerCols, Fetch fetch)
+{
+    using Traits = PixelTraits<Pixel>;
+
+    if (Rows>0)
+        kerRows = Rows;
+    if (Columns>0)
+        kerCols = Columns;
+    qreal sum[Traits::Channels] = {};
+    for (int i=0; i<kerRows; ++i)
+    {
+        for (int j=0; j<kerCols; ++j)
+        {
+            const Pixel pix = fetch(i,j);
+            const qreal kerVar = taps[i*kerCols+j];
+            for (int c=0; c<Traits::Channels; ++c)
+            {
+                sum[c] += Traits::channel(pix,c)*kerVar;
+            }
+        }
+    }
+    int channels[Traits::Channels];
+    for (int c=0; c<Traits::Channels; ++c)
+    {
+        channels[c] = qBound(0,static_cast<int>(sum[c]),0xff);
+    }
+    return Traits::pixel(channels);
+}
+
+/*!
+    \internal
+
+    The columns in [kerCenter, width-kerCenter) are the interior,
+    where every tap of the kernel falls inside the image.
+ */
+static inline void interiorColumns(const int width, const int kerCenter, int* begin, int* end)
+{
+    *begin = qMin(kerCenter,width);
+    *end = qMax(*begin,width-kerCenter);
+}
+
+/*!
+    \internal
+
+    The rows of the window are looked up from a precalculated index table,
+    and only the border strips of the columns go through the padding.
+    The interior of every row is convolved straight from the scanlines.
+ */
+template<typename Pixel, int Rows = 0, int Columns = 0>
+static QImage convolve_Impl(const QImage& image, const MatrixKernel& kernel, PaddingType padding)
+{
+    using Traits = PixelTraits<Pixel>;
+
+    QImage output(image.size(),Traits::format());
+    const QImage input = image.convertToFormat(Traits::format());
+
+    const int width = image.width();
+    const int height = image.height();
+    const int kerRows = Rows>0 ? Rows : kernel.rows();
+    const int kerCols = Columns>0 ? Columns : kernel.columns();
+    Q_ASSUME(kerRows%2==1);
+    Q_ASSUME(kerCols%2==1);
+    const int kerCenterX = kerCols/2;
+    const int kerCenterY = kerRows/2;
+    const QVector<qreal> taps = kernelTaps(kernel);
+    const QVector<int> indicesX = paddingIndices(width,kerCenterX,padding);
+    const QVector<int> indicesY = paddingIndices(height,kerCenterY,padding);
+    int interiorBegin, interiorEnd;
+    interiorColumns(width,kerCenterX,&interiorBegin,&interiorEnd);
+
+    uchar* const outputBits = output.bits();
+    const int outputStride = output.bytesPerLine();
+    parallelForRows(height,input.bytesPerLine(),[&](int begin, int end){
+        QVector<const Pixel*> rows(kerRows);
+        for (int y=begin; y<end; ++y)
+        {
+            for (int i=0; i<kerRows; ++i)
+            {
+                rows[i] = reinterpret_cast<const Pixel*>(input.constScanLine(indicesY.at(y+i)));
+            }
+            const Pixel* const* window = rows.constData();
+            Pixel* line = reinterpret_cast<Pixel*>(outputBits+y*outputStride);
+            const auto border = [&](int x) {
+                line[x] = convolvePixel<Pixel,Rows,Columns>(taps.constData(),kerRows,kerCols,[&](int i, int j){
+                    return window[i][indicesX.at(x+j)];
+                });
+            };
+
+            for (int x=0; x<interiorBegin; ++x)
+            {
+                border(x);
+            }
+            for (int x=interiorBegin; x<interiorEnd; ++x)
+            {
+                const int left = x-kerCenterX;
+                line[x] = convolvePixel<Pixel,Rows,Columns>(taps.constData(),kerRows,kerCols,[&](int i, int j){
+                    return window[i][left+j];
+                });
+            }
+            for (int x=interiorEnd; x<width; ++x)
+            {
+                border(x);
+            }
+        }
+    });
+    MAYBE_INTERRUPT();
+
+    return output.convertToFormat(image.format());
+}
+
+/*!
+    \internal
+
+    The rows beyond the image point to a line of padding color,
+    and only the border strips of the columns are checked against the image.
+ */
+template<typename Pixel, int Rows = 0, int Columns = 0>
+static QImage convolve_Impl(const QImage& image, const MatrixKernel& kernel, Pixel padding)
+{
+    using Traits = PixelTraits<Pixel>;
+
+    QImage output(image.size(),Traits::format());
+    const QImage input = image.convertToFormat(Traits::format());
+
+    const int width = image.width();
+    const int height = image.height();
+    const int kerRows = Rows>0 ? Rows : kernel.rows();
+    const int kerCols = Columns>0 ? Columns : kernel.columns();
+    Q_ASSUME(kerRows%2==1);
+    Q_ASSUME(kerCols%2==1);
+    const int kerCenterX = kerCols/2;
+    const int kerCenterY = kerRows/2;
+    const QVector<qreal> taps = kernelTaps(kernel);
+    const QVector<Pixel> paddingLine(width,padding);
+    int interiorBegin, interiorEnd;
+    interiorColumns(width,kerCenterX,&interiorBegin,&interiorEnd);
+
+    uchar* const outputBits = output.bits();
+    const int outputStride = output.bytesPerLine();
+    parallelForRows(height,input.bytesPerLine(),[&](int begin, int end){
+        QVector<const Pixel*> rows(kerRows);
+        for (int y=begin; y<end; ++y)
+        {
+            for (int i=0; i<kerRows; ++i)
+            {
+                const int yy = y+i-kerCenterY;
+                rows[i] = yy>=0 && yy<height ? reinterpret_cast<const Pixel*>(input.constScanLine(yy))
+                                             : paddingLine.constData();
+            }
+            const Pixel* const* window = rows.constData();
+            Pixel* line = reinterpret_cast<Pixel*>(outputBits+y*outputStride);
+            const auto border = [&](int x) {
+                line[x] = convolvePixel<Pixel,Rows,Columns>(taps.constData(),kerRows,kerCols,[&](int i, int j){
+                    const int xx = x+j-kerCenterX;
+                    return xx>=0 && xx<width ? window[i][xx] : padding;
+                });
+            };
+
+            for (int x=0; x<interiorBegin; ++x)
+            {
+                border(x);
+            }
+            for (int x=interiorBegin; x<interiorEnd; ++x)
+            {
+                const int left = x-kerCenterX;
+                line[x] = convolvePixel<Pixel,Rows,Columns>(taps.constData(),kerRows,kerCols,[&](int i, int j){
+                    return window[i][left+j];
+                });
+            }
+            for (int x=interiorEnd; x<width; ++x)
+            {
+                border(x);
+            }
+        }
+    });
+    MAYBE_INTERRUPT();
+
+    return output.convertToFormat(image.format());
+}
+
+/*!
+    \internal
+
+    Estimate whether convolveFFT() is faster than the spatial convolution of
+    an image of \a size with \a channels, by the \a kernel of \a taps per pixel.
+
+    A butterfly of the transform costs about as much as five multiply-adds
+    of the spatial convolution, and each complex plane holds two channels.
+ */
+static bool fftIsFaster(const QSize& size, const int channels, const MatrixKernel& kernel, const int taps)
+{
+    static constexpr qreal ButterflyCost = 5.;
+
+    const int sizeX = FftPlan::fastSize(size.width()+kernel.columns()-1);
+    const int sizeY = FftPlan::fastSize(size.height()+kernel.rows()-1);
+    const qreal points = qreal(sizeX)*sizeY;
+    const qreal fftCost = (channels+1)/2*points*::std::log2(points)*ButterflyCost;
+    const qreal spatialCost = qreal(size.width())*size.height()*channels*taps;
+    return fftCost < spatialCost;
+}
+
+/*!
+    Convolve the \a image with \a kernel, using specified padding type \a padding
+
+    If the \a kernel is separable, the convolution is performed by convolveSeparable().
+    If the \a kernel is so large that the frequency domain is estimated to be faster,
+    the convolution is performed by convolveFFT() instead.
+ */
+QImage convolve(const QImage& image, const MatrixKernel& kernel, PaddingType padding)
+{
+    MatrixKernel column, row;
+    const bool separable = kernel.rows()>1 && kernel.columns()>1 && kernel.separate(&column,&row);
+    const int taps = separable ? kernel.rows()+kernel.columns() : kernel.rows()*kernel.columns();
+    const bool gray = image.allGray();
+    if (fftIsFaster(image.size(),gray ? 1 : 3,kernel,taps))
+        return convolveFFT(image,kernel,padding);
+    if (separable)
+        return convolveSeparable(image,column,row,padding);
+
+    return gray ? convolve_Impl<uchar>(image,kernel,padding)
+                : convolve_Impl<QRgb>(image,kernel,padding);
+}
+
+/*!
+    \overload convolve
+
+    Convolve the \a image with \a kernel, using specified padding color \a padding
+ */
+QImage convolve(const QImage& image, const MatrixKernel& kernel, QRgb padding)
+{
+    MatrixKernel column, row;
+    const bool separable = kernel.rows()>1 && kernel.columns()>1 && kernel.separate(&column,&row);
+    const int taps = separable ? kernel.rows()+kernel.columns() : kernel.rows()*kernel.columns();
+    const bool gray = image.allGray() && qIsGray(padding);
+    if (fftIsFaster(image.size(),gray ? 1 : 3,kernel,taps))
+        return convolveFFT(image,kernel,padding);
+    if (separable)
+        return convolveSeparable(image,column,row,padding);
+
+    return gray
+            ? convolve_Impl<uchar>(image,kernel,static_cast<uchar>(qGray(padding)))
+            : convolve_Impl<QRgb>(image,kernel,padding);
+}
+
+/*!
+    \overload convolve
+
+    Convolve the \a image with \a kernel, using specified padding color \a padding
+ */
+QImage convolve(const QImage& image, const MatrixKernel& kernel, const QColor& padding)
+{
+    return convolve(image,kernel,padding.rgb());
+}
+
+/*!
+    \overload convolve
+
+    Convolve the \a image with the fixed-size \a kernel, using specified padding type \a padding
+
+    The taps are unrolled at compile time. Unlike the MatrixKernel overload,
+    a separable \a kernel is not split into two passes, which does not pay off for such small kernels.
+    It is instantiated for kernels of 3x3, 5x5, and 7x7.
+    A FixedKernel of any other size is converted to MatrixKernel, and takes the general overload instead.
+ */
+template<int Rows, int Columns, EnableFixedConvolve<Rows,Columns>>
+QImage convolve(const QImage& image, const FixedKernel<Rows,Columns>& kernel, PaddingType padding)
+{
+    const MatrixKernel ker(kernel);
+    return image.allGray() ? convolve_Impl<uchar,Rows,Columns>(image,ker,padding)
+                           : convolve_Impl<QRgb,Rows,Columns>(image,ker,padding);
+}
+
+/*!
+    \overload convolve
+
+    Convolve the \a image with the fixed-size \a kernel, using specified padding color \a padding
+ */
+template<int Rows, int Columns, EnableFixedConvolve<Rows,Columns>>
+QImage convolve(const QImage& image, const FixedKernel<Rows,Columns>& kernel, QRgb padding)
+{
+    const MatrixKernel ker(kernel);
+    return image.allGray() && qIsGray(padding)
+            ? convolve_Impl<uchar,Rows,Columns>(image,ker,static_cast<uchar>(qGray(padding)))
+            : convolve_Impl<QRgb,Rows,Columns>(image,ker,padding);
+}
+
+/*!
+    \overload convolve
+
+    Convolve the \a image with the fixed-size \a kernel, using specified padding color \a padding
+ */
+template<int Rows, int Columns, EnableFixedConvolve<Rows,Columns>>
+QImage convolve(const QImage& image, const FixedKernel<Rows,Columns>& kernel, const QColor& padding)
+{
+    return convolve(image,kernel,padding.rgb());
+}
+
+#define INSTANTIATE_FIXED_CONVOLVE(Rows, Columns) \
+    template QImage convolve(const QImage&, const FixedKernel<Rows,Columns>&, PaddingType); \
+    template QImage convolve(const QImage&, const FixedKernel<Rows,Columns>&, QRgb); \
+    template QImage convolve(const QImage&, const FixedKernel<Rows,Columns>&, const QColor&);
+
+INSTANTIATE_FIXED_CONVOLVE(3,3)
+INSTANTIATE_FIXED_CONVOLVE(5,5)
+INSTANTIATE_FIXED_CONVOLVE(7,7)
+
+#undef INSTANTIATE_FIXED_CONVOLVE
+
+/*!
+    \internal
+
+    Flip the quantized \a weights of \a kerRows x \a kerCols into convolution order.
+ */
+static QVector<qint32> flippedWeights(const QVector<qint32>& weights, const int kerRows, const int kerCols)
+{
+    QVector<qint32> flipped(weights.size());
+    for (int i=0; i<kerRows; ++i)
+    {
+        for (int j=0; j<kerCols; ++j)
+        {
+            flipped[i*kerCols+j] = weights.at((kerRows-1-i)*kerCols+kerCols-1-j);
+        }
+    }
+    return flipped;
+}
+
+#ifdef __SSE2__
+/*!
+    \internal
+
+    Multiply 32-bit integers in \a a and \a b, keeping the low 32 bits of the products.
+ */
+static inline __m128i mulloEpi32(__m128i a, __m128i b)
+{
+    const __m128i even = _mm_mul_epu32(a,b);
+    const __m128i odd = _mm_mul_epu32(_mm_srli_si128(a,4),_mm_srli_si128(b,4));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even,_MM_SHUFFLE(0,0,2,0)),
+                              _mm_shuffle_epi32(odd,_MM_SHUFFLE(0,0,2,0)));
+}
+#endif // __SSE2__
+
+/*!
+    \internal
+
+    Add \a weight times each of the \a length samples of \a src to \a accumulator.
+ */
+static inline void multiplyAccumulate(const uchar* src, const qint32 weight, const int length, qint32* accumulator)
+{
+    int k = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i w = _mm_set1_epi32(weight);
+    for (; k+16<=length; k+=16)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src+k));
+        const __m128i lo = _mm_unpacklo_epi8(v,zero);
+        const __m128i hi = _mm_unpackhi_epi8(v,zero);
+        const __m128i samples[4] = {
+            _mm_unpacklo_epi16(lo,zero), _mm_unpackhi_epi16(lo,zero),
+            _mm_unpacklo_epi16(hi,zero), _mm_unpackhi_epi16(hi,zero),
+        };
+        for (int q=0; q<4; ++q)
+        {
+            __m128i* acc = reinterpret_cast<__m128i*>(accumulator+k+4*q);
+            _mm_storeu_si128(acc,_mm_add_epi32(_mm_loadu_si128(acc),mulloEpi32(samples[q],w)));
+        }
+    }
+#endif // __SSE2__
+    for (; k<length; ++k)
+    {
+        accumulator[k] += weight*src[k];
+    }
+}
+
+/*!
+    \internal
+    \overload multiplyAccumulate
+ */
+static inline void multiplyAccumulate(const qint32* src, const qint32 weight, const int length, qint32* accumulator)
+{
+    int k = 0;
+#ifdef __SSE2__
+    const __m128i w = _mm_set1_epi32(weight);
+    for (; k+4<=length; k+=4)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src+k));
+        __m128i* acc = reinterpret_cast<__m128i*>(accumulator+k);
+        _mm_storeu_si128(acc,_mm_add_epi32(_mm_loadu_si128(acc),mulloEpi32(v,w)));
+    }
+#endif // __SSE2__
+    for (; k<length; ++k)
+    {
+        accumulator[k] += weight*src[k];
+    }
+}
+
+/*!
+    \internal
+
+    Scale the fixed-point \a accumulator of \a width pixels down by \a shift bits,
+    and write the saturated bytes to \a line.
+ */
+template<typename Pixel>
+static inline void storeQuantized(const qint32* accumulator, const int width, const int shift, Pixel* line)
+{
+    uchar* bytes = reinterpret_cast<uchar*>(line);
+    for (int k=0; k<int(sizeof(Pixel))*width; ++k)
+    {
+        bytes[k] = static_cast<uchar>(qBound(0,accumulator[k]>>shift,0xff));
+    }
+    if (PixelTraits<Pixel>::Channels>1)
+    {
+        for (int x=0; x<width; ++x)
+        {
+            line[x] |= 0xff000000;
+        }
+    }
+}
+
+/*!
+    \internal
+
+    Pad the \a input image of the working format by \a radiusX and \a radiusY on each side,
+    using specified padding type \a padding.
+ */
+template<typename Pixel>
+static QVector<Pixel> extendedImage(const QImage& input, const int radiusX, const int radiusY, PaddingType padding)
+{
+    const int width = input.width();
+    const int extWidth = width+2*radiusX;
+    const QVector<int> indicesX = paddingIndices(width,radiusX,padding);
+    const QVector<int> indicesY = paddingIndices(input.height(),radiusY,padding);
+
+    QVector<Pixel> extended(extWidth*indicesY.size());
+    for (int y=0; y<indicesY.size(); ++y)
+    {
+        const Pixel* iLine = reinterpret_cast<const Pixel*>(input.constScanLine(indicesY.at(y)));
+        Pixel* eLine = extended.data()+extWidth*y;
+        for (int x=0; x<extWidth; ++x)
+        {
+            eLine[x] = iLine[indicesX.at(x)];
+        }
+    }
+    return extended;
+}
+
+/*!
+    \internal
+
+    Pad the \a input image of the working format by \a radiusX and \a radiusY on each side,
+    using specified padding color \a padding.
+ */
+template<typename Pixel>
+static QVector<Pixel> extendedImage(const QImage& input, const int radiusX, const int radiusY, Pixel padding)
+{
+    const int width = input.width();
+    const int height = input.height();
+    const int extWidth = width+2*radiusX;
+
+    QVector<Pixel> extended(extWidth*(height+2*radiusY),padding);
+    for (int y=0; y<height; ++y)
+    {
+        const Pixel* iLine = reinterpret_cast<const Pixel*>(input.constScanLine(y));
+        ::std::copy(iLine,iLine+width,extended.begin()+extWidth*(y+radiusY)+radiusX);
+    }
+    return extended;
+}
+
+/*!
+    \internal
+
+    Convolve the \a extended image, which is the image of \a width x \a height
+    padded by the kernel radius on each side, with the quantized kernel \a weights
+    in convolution order.
+
+    The channels are treated as independent bytes, so the inner loop is a plain
+    multiply-accumulate of 32-bit integers.
+ */
+template<typename Pixel>
+static QImage convolveQuantized(const QVector<Pixel>& extended, const int width, const int height,
+                                const QVector<qint32>& weights, const int kerRows, const int kerCols,
+                                const int shift)
+{
+    QImage output(width,height,PixelTraits<Pixel>::format());
+
+    const int extWidth = width+kerCols-1;
+    const int length = sizeof(Pixel)*width;
+    const uchar* const extBits = reinterpret_cast<const uchar*>(extended.constData());
+    uchar* const outputBits = output.bits();
+    const int outputStride = output.bytesPerLine();
+    parallelForRows(height,length,[&](int begin, int end){
+        QVector<qint32> accumulator(length);
+        for (int y=begin; y<end; ++y)
+        {
+            ::std::fill(accumulator.begin(),accumulator.end(),0);
+            qint32* const acc = accumulator.data();
+            for (int i=0; i<kerRows; ++i)
+            {
+                const uchar* const extLine = extBits+sizeof(Pixel)*extWidth*(y+i);
+                for (int j=0; j<kerCols; ++j)
+                {
+                    multiplyAccumulate(extLine+sizeof(Pixel)*j,weights.at(i*kerCols+j),length,acc);
+                }
+            }
+            storeQuantized(acc,width,shift,reinterpret_cast<Pixel*>(outputBits+y*outputStride));
+        }
+    });
+    MAYBE_INTERRUPT();
+
+    return output;
+}
+
+/*!
+    \internal
+
+    Same as convolveQuantized(), but with the separable kernel of \a columnWeights
+    and \a rowWeights in convolution order.
+
+    The result of the horizontal pass is rounded by \a intermediateShift bits
+    before the vertical pass, and the final result is scaled down by \a shift bits.
+ */
+template<typename Pixel>
+static QImage convolveQuantizedSeparable(const QVector<Pixel>& extended, const int width, const int height,
+                                         const QVector<qint32>& columnWeights, const QVector<qint32>& rowWeights,
+                                         const int intermediateShift, const int shift)
+{
+    QImage output(width,height,PixelTraits<Pixel>::format());
+
+    const int kerRows = columnWeights.size();
+    const int kerCols = rowWeights.size();
+    const int extWidth = width+kerCols-1;
+    const int length = sizeof(Pixel)*width;
+    const uchar* const extBits = reinterpret_cast<const uchar*>(extended.constData());
+    const qint32 rounding = intermediateShift>0 ? 1<<(intermediateShift-1) : 0;
+    const auto rowPass = [&](int y, qint32* acc) {
+        const uchar* const extLine = extBits+sizeof(Pixel)*extWidth*y;
+        ::std::fill(acc,acc+length,rounding);
+        for (int j=0; j<kerCols; ++j)
+        {
+            multiplyAccumulate(extLine+sizeof(Pixel)*j,rowWeights.at(j),length,acc);
+        }
+        for (int k=0; k<length; ++k)
+        {
+            acc[k] >>= intermediateShift;
+        }
+    };
+
+    uchar* const outputBits = output.bits();
+    const int outputStride = output.bytesPerLine();
+    parallelForRows(height,length,[&](int begin, int end){
+        // the horizontal pass of the last kerRows rows, used as a ring buffer
+        QVector<qint32> rows(kerRows*length);
+        QVector<qint32> accumulator(length);
+        for (int i=0; i<kerRows-1; ++i)
+        {
+            rowPass(begin+i,rows.data()+length*((begin+i)%kerRows));
+        }
+        for (int y=begin; y<end; ++y)
+        {
+            rowPass(y+kerRows-1,rows.data()+length*((y+kerRows-1)%kerRows));
+
+            ::std::fill(accumulator.begin(),accumulator.end(),0);
+            qint32* const acc = accumulator.data();
+            for (int i=0; i<kerRows; ++i)
+            {
+                multiplyAccumulate(rows.constData()+length*((y+i)%kerRows),columnWeights.at(i),length,acc);
+            }
+            storeQuantized(acc,width,shift,reinterpret_cast<Pixel*>(outputBits+y*outputStride));
+        }
+    });
+    MAYBE_INTERRUPT();
+
+    return output;
+}
+
+/*!
+    \internal
+
+    Dispatch the \a extended image to the convolution of the quantized \a kernel.
+ */
+template<typename Pixel>
+static QImage convolveQuantized(const QVector<Pixel>& extended, const int width, const int height,
+                                const QVector<qint32>& weights,
+                                const QVector<qint32>& columnWeights,
+                                const QVector<qint32>& rowWeights,
+                                const int kerRows, const int kerCols,
+                                const int intermediateShift, const int fractionBits)
+{
+    if (!rowWeights.isEmpty())
+    {
+        return convolveQuantizedSeparable(extended,width,height,
+                                          flippedWeights(columnWeights,kerRows,1),
+                                          flippedWeights(rowWeights,1,kerCols),
+                                          intermediateShift,2*fractionBits-intermediateShift);
+    }
+    return convolveQuantized(extended,width,height,
+                             flippedWeights(weights,kerRows,kerCols),kerRows,kerCols,
+                             fractionBits);
+}
+
+/*!
+    \overload convolve
+
+    Convolve the \a image with the fixed-point \a kernel, using specified padding type \a padding
+
+    Only integer arithmetic is used. The result differs from convolving with the original
+    floating-point kernel by at most ceil(QuantizedKernel::maxError()) levels in each channel.
+
+    \sa MatrixKernel::quantized()
+ */
+QImage convolve(const QImage& image, const QuantizedKernel& kernel, PaddingType padding)
+{
+    const int width = image.width();
+    const int height = image.height();
+    const int kerCenterX = kernel.kerCols/2;
+    const int kerCenterY = kernel.kerRows/2;
+    const auto convolveExtended = [&](const auto& extended) {
+        return convolveQuantized(extended,width,height,kernel.weights,
+                                 kernel.columnWeights,kernel.rowWeights,
+                                 kernel.kerRows,kernel.kerCols,
+                                 kernel.intermediateShift,kernel.bits);
+    };
+
+    const QImage output = image.allGray()
+            ? convolveExtended(extendedImage<uchar>(image.convertToFormat(QImage::Format_Grayscale8),
+                                                    kerCenterX,kerCenterY,padding))
+            : convolveExtended(extendedImage<QRgb>(image.convertToFormat(QImage::Format_RGB32),
+                                                   kerCenterX,kerCenterY,padding));
+    return output.convertToFormat(image.format());
+}
+
+/*!
+    \overload convolve
+
+    Convolve the \a image with the fixed-point \a kernel, using specified padding color \a padding
+ */
+QImage convolve(const QImage& image, const QuantizedKernel& kernel, QRgb padding)
+{
+    const int width = image.width();
+    const int height = image.height();
+    const int kerCenterX = kernel.kerCols/2;
+    const int kerCenterY = kernel.kerRows/2;
+    const auto convolveExtended = [&](const auto& extended) {
+        return convolveQuantized(extended,width,height,kernel.weights,
+                                 kernel.columnWeights,kernel.rowWeights,
+                                 kernel.kerRows,kernel.kerCols,
+                                 kernel.intermediateShift,kernel.bits);
+    };
+
+    const QImage output = image.allGray() && qIsGray(padding)
+            ? convolveExtended(extendedImage<uchar>(image.convertToFormat(QImage::Format_Grayscale8),
+                                                    kerCenterX,kerCenterY,static_cast<uchar>(qGray(padding))))
+            : convolveExtended(extendedImage<QRgb>(image.convertToFormat(QImage::Format_RGB32),
+                                                   kerCenterX,kerCenterY,padding));
+    return output.convertToFormat(image.format());
+}
+
+/*!
+    \overload convolve
+
+    Convolve the \a image with the fixed-point \a kernel, using specified padding color \a padding
+ */
+QImage convolve(const QImage& image, const QuantizedKernel& kernel, const QColor& padding)
+{
+    return convolve(image,kernel,padding.rgb());
+}
+
+/*!
+    \internal
+
+    Transform the rows in [\a rowBegin, \a rowEnd) of \a data, which has \a plan.size() columns,
+    forward or \a inverse in place.
+ */
+static void transformRows(Complex* data, const int rowBegin, const int rowEnd, const FftPlan& plan,
+                          const bool inverse, qreal progressBegin, qreal progressEnd)
+{
+    const int sizeX = plan.size();
+    parallelForRows(rowEnd-rowBegin,sizeX*sizeof(Complex),[&](int begin, int end){
+        QVector<Complex> line(sizeX);
+        for (int y=rowBegin+begin; y<rowBegin+end; ++y)
+        {
+            Complex* row = data+sizeX*y;
+            ::std::copy(row,row+sizeX,line.begin());
+            if (inverse)
+                plan.inverseTransform(line.constData(),row);
+            else
+                plan.transform(line.constData(),row);
+        }
+    },progressBegin,progressEnd);
+}
+
+/*!
+    \internal
+
+    Transform every column of \a data forward, multiply it by the column of \a spectrum,
+    which is stored column by column, and transform it back, i.e. the circular convolution along the columns.
+    The row transforms should be done before and after this.
+ */
+static void filterColumns(Complex* data, const Complex* spectrum, const int sizeX, const FftPlan& plan,
+                          qreal progressBegin, qreal progressEnd)
+{
+    const int sizeY = plan.size();
+    parallelForRows(sizeX,sizeY*sizeof(Complex),[&](int begin, int end){
+        QVector<Complex> column(sizeY);
+        QVector<Complex> result(sizeY);
+        for (int x=begin; x<end; ++x)
+        {
+            plan.transform(data+x,column.data(),sizeX);
+            const Complex* factors = spectrum+sizeY*x;
+            for (int y=0; y<sizeY; ++y)
+            {
+                // written out, since the operator of std::complex checks for NaN out of line
+                const Complex value = column.at(y);
+                column[y] = Complex(value.real()*factors[y].real()-value.imag()*factors[y].imag(),
+                                    value.real()*factors[y].imag()+value.imag()*factors[y].real());
+            }
+            plan.inverseTransform(column.constData(),result.data());
+            for (int y=0; y<sizeY; ++y)
+            {
+                data[sizeX*y+x] = result.at(y);
+            }
+        }
+    },progressBegin,progressEnd);
+}
+
+/*!
+    \internal
+
+    The 2D transform of \a kernel, zero-padded to \a sizeX x \a sizeY,
+    stored column by column for filterColumns().
+
+    The spectra of the recently used kernels are cached for each size,
+    since the frames of a sequence are usually filtered with the same kernel.
+ */
+static QVector<Complex> kernelSpectrum(const MatrixKernel& kernel, const int sizeX, const int sizeY)
+{
+    struct CachedSpectrum
+    {
+        MatrixKernel kernel;
+        int sizeX;
+        int sizeY;
+        QVector<Complex> spectrum;
+    };
+    static constexpr int MaxCachedSpectra = 4;
+    static QMutex mutex;
+    static QList<CachedSpectrum> cache; // the most recently used first
+
+    const int kerRows = kernel.rows();
+    const int kerCols = kernel.columns();
+    const auto matches = [&](const CachedSpectrum& cached) {
+        return cached.sizeX==sizeX && cached.sizeY==sizeY
+                && cached.kernel.rows()==kerRows && cached.kernel.columns()==kerCols
+                && ::std::equal(kernel.constData(),kernel.constData()+kerRows*kerCols,
+                                cached.kernel.constData());
+    };
+    {
+        QMutexLocker locker(&mutex);
+        for (int i=0; i<cache.size(); ++i)
+        {
+            if (matches(cache.at(i)))
+            {
+                cache.move(i,0);
+                return cache.first().spectrum;
+            }
+        }
+    }
+
+    QVector<Complex> rows(sizeX*kerRows);
+    for (int i=0; i<kerRows; ++i)
+    {
+        for (int j=0; j<kerCols; ++j)
+        {
+            rows[sizeX*i+j] = kernel.at(i,j);
+        }
+    }
+    const FftPlan planX(sizeX);
+    const FftPlan planY(sizeY);
+    transformRows(rows.data(),0,kerRows,planX,false,0,0);
+
+    QVector<Complex> spectrum(sizeX*sizeY);
+    parallelForRows(sizeX,sizeY*sizeof(Complex),[&](int begin, int end){
+        QVector<Complex> column(sizeY);
+        for (int x=begin; x<end; ++x)
+        {
+            for (int y=0; y<kerRows; ++y)
+            {
+                column[y] = rows.at(sizeX*y+x);
+            }
+            ::std::fill(column.begin()+kerRows,column.end(),Complex());
+            planY.transform(column.constData(),spectrum.data()+sizeY*x);
+        }
+    },0,0);
+
+    QMutexLocker locker(&mutex);
+    cache.prepend(CachedSpectrum{kernel,sizeX,sizeY,spectrum});
+    while (cache.size() > MaxCachedSpectra)
+        cache.removeLast();
+    return spectrum;
+}
+
+/*!
+    \internal
+
+    Convolve the \a extended image, which is the image of \a width x \a height
+    padded by the half size of \a kernel on each side, in the frequency domain.
+
+    Two channels are transformed together as the real and imaginary parts,
+    as the kernel is real. The transform size only needs to cover the extended image,
+    because the wrap-around of the circular convolution falls in the padding.
+ */
+template<typename Pixel>
+static QImage convolveFFT_Impl(const QVector<Pixel>& extended, const int width, const int height,
+                               const MatrixKernel& kernel)
+{
+    using Traits = PixelTraits<Pixel>;
+
+    QImage output(width,height,Traits::format());
+
+    const int kerRows = kernel.rows();
+    const int kerCols = kernel.columns();
+    const int extWidth = width+kerCols-1;
+    const int extHeight = height+kerRows-1;
+    const int sizeX = FftPlan::fastSize(extWidth);
+    const int sizeY = FftPlan::fastSize(extHeight);
+    const FftPlan planX(sizeX);
+    const FftPlan planY(sizeY);
+    const QVector<Complex> spectrum = kernelSpectrum(kernel,sizeX,sizeY);
+    MAYBE_INTERRUPT();
+
+    constexpr int Planes = (Traits::Channels+1)/2;
+    const int count = Traits::Channels*width;
+    QVector<qreal> result(count*height);
+    QVector<Complex> data(sizeX*sizeY);
+    for (int plane=0; plane<Planes; ++plane)
+    {
+        const int real = 2*plane;
+        const int imag = 2*plane+1;
+        const qreal progress = qreal(plane)/Planes;
+        const qreal progressStep = qreal(1)/Planes;
+
+        ::std::fill(data.begin(),data.end(),Complex());
+        for (int y=0; y<extHeight; ++y)
+        {
+            const Pixel* eLine = extended.constData()+extWidth*y;
+            Complex* line = data.data()+sizeX*y;
+            for (int x=0; x<extWidth; ++x)
+            {
+                line[x] = Complex(Traits::channel(eLine[x],real),
+                                  imag<Traits::Channels ? Traits::channel(eLine[x],imag) : 0);
+            }
+        }
+        // the rows beyond the extended image are zero, and so are their transforms
+        transformRows(data.data(),0,extHeight,planX,false,progress,progress+progressStep/3);
+        MAYBE_INTERRUPT();
+        filterColumns(data.data(),spectrum.constData(),sizeX,planY,
+                      progress+progressStep/3,progress+progressStep*2/3);
+        MAYBE_INTERRUPT();
+        transformRows(data.data(),kerRows-1,extHeight,planX,true,
+                      progress+progressStep*2/3,progress+progressStep);
+        MAYBE_INTERRUPT();
+
+        for (int y=0; y<height; ++y)
+        {
+            const Complex* line = data.constData()+sizeX*(y+kerRows-1)+kerCols-1;
+            qreal* rLine = result.data()+count*y;
+            for (int x=0; x<width; ++x)
+            {
+                rLine[Traits::Channels*x+real] = line[x].real();
+                if (imag < Traits::Channels)
+                    rLine[Traits::Channels*x+imag] = line[x].imag();
+            }
+        }
+    }
+
+    for (int y=0; y<height; ++y)
+    {
+        const qreal* rLine = result.constData()+count*y;
+        Pixel* line = reinterpret_cast<Pixel*>(output.scanLine(y));
+        for (int x=0; x<width; ++x)
+        {
+            int channels[Traits::Channels];
+            for (int c=0; c<Traits::Channels; ++c)
+            {
+                channels[c] = qBound(0,static_cast<int>(rLine[Traits::Channels*x+c]),0xff);
+            }
+            line[x] = Traits::pixel(channels);
+        }
+    }
+
+    return output;
+}
+
+/*!
+    Convolve the \a image with \a kernel in the frequency domain, using specified padding type \a padding
+
+    The cost per pixel grows only with the logarithm of the image size, instead of the size of \a kernel,
+    so it is faster than the spatial convolution for large kernels. The result is the same as convolve(),
+    except that the rounding errors may change a channel by one level.
+
+    \sa FftPlan
+ */
+QImage convolveFFT(const QImage& image, const MatrixKernel& kernel, PaddingType padding)
+{
+    Q_ASSUME(kernel.rows()%2==1);
+    Q_ASSUME(kernel.columns()%2==1);
+
+    const int width = image.width();
+    const int height = image.height();
+    const int kerCenterX = kernel.columns()/2;
+    const int kerCenterY = kernel.rows()/2;
+
+    const QImage output = image.allGray()
+            ? convolveFFT_Impl(extendedImage<uchar>(image.convertToFormat(QImage::Format_Grayscale8),
+                                                    kerCenterX,kerCenterY,padding),
+                               width,height,kernel)
+            : convolveFFT_Impl(extendedImage<QRgb>(image.convertToFormat(QImage::Format_RGB32),
+                                                   kerCenterX,kerCenterY,padding),
+                               width,height,kernel);
+    return output.convertToFormat(image.format());
+}
+
+/*!
+    \overload convolveFFT
+
+    Convolve the \a image with \a kernel in the frequency domain, using specified padding color \a padding
+ */
+QImage convolveFFT(const QImage& image, const MatrixKernel& kernel, QRgb padding)
+{
+    Q_ASSUME(kernel.rows()%2==1);
+    Q_ASSUME(kernel.columns()%2==1);
+
+    const int width = image.width();
+    const int height = image.height();
+    const int kerCenterX = kernel.columns()/2;
+    const int kerCenterY = kernel.rows()/2;
+
+    const QImage output = image.allGray() && qIsGray(padding)
+            ? convolveFFT_Impl(extendedImage<uchar>(image.convertToFormat(QImage::Format_Grayscale8),
+                                                    kerCenterX,kerCenterY,static_cast<uchar>(qGray(padding))),
+                               width,height,kernel)
+            : convolveFFT_Impl(extendedImage<QRgb>(image.convertToFormat(QImage::Format_RGB32),
+                                                   kerCenterX,kerCenterY,padding),
+                               width,height,kernel);
+    return output.convertToFormat(image.format());
+}
+
+/*!
+    \overload convolveFFT
+
+    Convolve the \a image with \a kernel in the frequency domain, using specified padding color \a padding
+ */
+QImage convolveFFT(const QImage& image, const MatrixKernel& kernel, const QColor& padding)
+{
+    return convolveFFT(image,kernel,padding.rgb());
+}
+
+/*!
+    \internal
+
+    Same as convolvePixel(), but convolve with \a tapsX and \a tapsY both,
+    and combine the two.
+ */
+template<typename Pixel, typename Fetch>
+static inline Pixel convolvePixelXY(const qreal* tapsX, const qreal* tapsY,
+                                    const int kerRows, const int kerCols, Fetch fetch)
+{
+    using ::std::hypot;
+    using Traits = PixelTraits<Pixel>;
+
+    qreal sumX[Traits::Channels] = {};
+    qreal sumY[Traits::Channels] = {};
+    for (int i=0; i<kerRows; ++i)
+    {
+        for (int j=0; j<kerCols; ++j)
+        {
+            const Pixel pix = fetch(i,j);
+            const qreal kerXVar = tapsX[i*kerCols+j];
+            const qreal kerYVar = tapsY[i*kerCols+j];
+            for (int c=0; c<Traits::Channels; ++c)
+            {
+                sumX[c] += Traits::channel(pix,c)*kerXVar;
+                sumY[c] += Traits::channel(pix,c)*kerYVar;
+            }
+        }
+    }
+    int channels[Traits::Channels];
+    for (int c=0; c<Traits::Channels; ++c)
+    {
+        channels[c] = qBound(0,static_cast<int>(hypot(sumX[c],sumY[c])),0xff);
+    }
+    return Traits::pixel(channels);
+}
+
+/*!
+    \internal
+
+    \sa convolve_Impl()
+ */
+template<typename Pixel>
+static QImage convolveXY_Impl(const QImage& image, const MatrixKernel& kerX, const MatrixKernel& kerY,
+                              PaddingType padding)
+{
+    using Traits = PixelTraits<Pixel>;
+
+    QImage output(image.size(),Traits::format());
+    const QImage input = image.convertToFormat(Traits::format());
+
+    const int width = image.width();
+    const int height = image.height();
+    Q_ASSUME(kerX.rows()==kerY.rows());
+    Q_ASSUME(kerX.columns()==kerY.columns());
+    const int kerRows = kerX.rows();
+    const int kerCols = kerX.columns();
+    Q_ASSUME(kerRows%2==1);
+    Q_ASSUME(kerCols%2==1);
+    const int kerCenterX = kerCols/2;
+    const int kerCenterY = kerRows/2;
+    const QVector<qreal> tapsX = kernelTaps(kerX);
+    const QVector<qreal> tapsY = kernelTaps(kerY);
+    const QVector<int> indicesX = paddingIndices(width,kerCenterX,padding);
+    const QVector<int> indicesY = paddingIndices(height,kerCenterY,padding);
+    int interiorBegin, interiorEnd;
+    interiorColumns(width,kerCenterX,&interiorBegin,&interiorEnd);
+
+    uchar* const outputBits = output.bits();
+    const int outputStride = output.bytesPerLine();
+    parallelForRows(height,input.bytesPerLine(),[&](int begin, int end){
+        QVector<const Pixel*> rows(kerRows);
+        for (int y=begin; y<end; ++y)
+        {
+            for (int i=0; i<kerRows; ++i)
+            {
+                rows[i] = reinterpret_cast<const Pixel*>(input.constScanLine(indicesY.at(y+i)));
+            }
+            const Pixel* const* window = rows.constData();
+            Pixel* line = reinterpret_cast<Pixel*>(outputBits+y*outputStride);
+            const auto border = [&](int x) {
+                line[x] = convolvePixelXY<Pixel>(tapsX.constData(),tapsY.constData(),kerRows,kerCols,
+                                                 [&](int i, int j){
+                    return window[i][indicesX.at(x+j)];
+                });
+            };
+
+            for (int x=0; x<interiorBegin; ++x)
+            {
+                border(x);
+            }
+            for (int x=interiorBegin; x<interiorEnd; ++x)
+            {
+                const int left = x-kerCenterX;
+                line[x] = convolvePixelXY<Pixel>(tapsX.constData(),tapsY.constData(),kerRows,kerCols,
+                                                 [&](int i, int j){
+                    return window[i][left+j];
+                });
+            }
+            for (int x=interiorEnd; x<width; ++x)
+            {
+                border(x);
+            }
+        }
+    });
+    MAYBE_INTERRUPT();
+
+    return output.convertToFormat(image.format());
+}
+
+/*!
+    \internal
+
+    \sa convolve_Impl()
+ */
+template<typename Pixel>
+static QImage convolveXY_Impl(const QImage& image, const MatrixKernel& kerX, const MatrixKernel& kerY,
+                              Pixel padding)
+{
+    using Traits = PixelTraits<Pixel>;
+
+    QImage output(image.size(),Traits::format());
+    const QImage input = image.convertToFormat(Traits::format());
+
+    const int width = image.width();
+    const int height = image.height();
+    Q_ASSUME(kerX.rows()==kerY.rows());
+    Q_ASSUME(kerX.columns()==kerY.columns());
     const int kerRows = kerX.rows();
     const int kerCols = kerX.columns();
     Q_ASSUME(kerRows%2==1);
     Q_ASSUME(kerCols%2==1);
     const int kerCenterX = kerCols/2;
     const int kerCenterY = kerRows/2;
+    const QVector<qreal> tapsX = kernelTaps(kerX);
+    const QVector<qreal> tapsY = kernelTaps(kerY);
+    const QVector<Pixel> paddingLine(width,padding);
+    int interiorBegin, interiorEnd;
+    interiorColumns(width,kerCenterX,&interiorBegin,&interiorEnd);
+
+    uchar* const outputBits = output.bits();
+    const int outputStride = output.bytesPerLine();
+    parallelForRows(height,input.bytesPerLine(),[&](int begin, int end){
+        QVector<const Pixel*> rows(kerRows);
+        for (int y=begin; y<end; ++y)
+        {
+            for (int i=0; i<kerRows; ++i)
+            {
+                const int yy = y+i-kerCenterY;
+                rows[i] = yy>=0 && yy<height ? reinterpret_cast<const Pixel*>(input.constScanLine(yy))
+                                             : paddingLine.constData();
+            }
+            const Pixel* const* window = rows.constData();
+            Pixel* line = reinterpret_cast<Pixel*>(outputBits+y*outputStride);
+            const auto border = [&](int x) {
+                line[x] = convolvePixelXY<Pixel>(tapsX.constData(),tapsY.constData(),kerRows,kerCols,
+                                                 [&](int i, int j){
+                    const int xx = x+j-kerCenterX;
+                    return xx>=0 && xx<width ? window[i][xx] : padding;
+                });
+            };
+
+            for (int x=0; x<interiorBegin; ++x)
+            {
+                border(x);
+            }
+            for (int x=interiorBegin; x<interiorEnd; ++x)
+            {
+                const int left = x-kerCenterX;
+                line[x] = convolvePixelXY<Pixel>(tapsX.constData(),tapsY.constData(),kerRows,kerCols,
+                                                 [&](int i, int j){
+                    return window[i][left+j];
+                });
+            }
+            for (int x=interiorEnd; x<width; ++x)
+            {
+                border(x);
+            }
+        }
+    });
+    MAYBE_INTERRUPT();
+
+    return output.convertToFormat(image.format());
+}
+
+/*!
+    Convolve the \a image with kernel \a kerX & \b kerY, using specified padding type \a padding,
+    and then combine the two.
+ */
+QImage convolveXY(const QImage& image, const MatrixKernel& kerX, const MatrixKernel& kerY, PaddingType padding)
+{
+    return image.allGray() ? convolveXY_Impl<uchar>(image,kerX,kerY,padding)
+                           : convolveXY_Impl<QRgb>(image,kerX,kerY,padding);
+}
 
-    for (int y=0; y<height; ++y)
+/*!
+    \overload convolveXY
+
+    Convolve the \a image with kernel \a kerX & \b kerY, using specified padding color \a padding,
+    and then combine the two.
+ */
+QImage convolveXY(const QImage& image, const MatrixKernel& kerX, const MatrixKernel& kerY, QRgb padding)
+{
+    return image.allGray() && qIsGray(padding)
+            ? convolveXY_Impl<uchar>(image,kerX,kerY,static_cast<uchar>(qGray(padding)))
+            : convolveXY_Impl<QRgb>(image,kerX,kerY,padding);
+}
+
+/*!
+    \overload convolveXY
+
+    Convolve the \a image with kernel \a kerX & \b kerY, using specified padding color \a padding,
+    and then combine the two.
+ */
+QImage convolveXY(const QImage& image, const MatrixKernel& kerX, const MatrixKernel& kerY, const QColor& padding)
+{
+    return convolveXY(image,kerX,kerY,padding.rgb());
+}
+
+/*!
+    \internal
+
+    The horizontal pass of box filter: slide a window of 2*\a radius+1 pixels over the
+    extended (padded) line \a extLine, and store the sum of each channel to \a out.
+ */
+template<typename Pixel>
+static void boxRowPass(const Pixel* extLine, const int width, const int radius, int* out)
+{
+    using Traits = PixelTraits<Pixel>;
+
+    int sum[Traits::Channels] = {};
+    for (int j=0; j<2*radius; ++j)
     {
-        QRgb* line = reinterpret_cast<QRgb*>(output.scanLine(y));
-        for (int x=0; x<width; ++x)
+        for (int c=0; c<Traits::Channels; ++c)
         {
-            qreal rx=0, gx=0, bx=0;
-            qreal ry=0, gy=0, by=0;
-            for (int i=0; i<kerRows; ++i)
+            sum[c] += Traits::channel(extLine[j],c);
+        }
+    }
+    for (int x=0; x<width; ++x)
+    {
+        const Pixel entering = extLine[x+2*radius];
+        const Pixel leaving = extLine[x];
+        for (int c=0; c<Traits::Channels; ++c)
+        {
+            sum[c] += Traits::channel(entering,c);
+            out[Traits::Channels*x+c] = sum[c];
+            sum[c] -= Traits::channel(leaving,c);
+        }
+    }
+}
+
+/*!
+    \internal
+
+    The vertical pass of box filter: slide a window of 2*\a radius+1 rows down,
+    where \a rows lists the row sums for every position in [-radius, height+radius).
+
+    Every band of rows runs its own window, so that the bands can be processed in parallel.
+ */
+template<typename Pixel>
+static void boxColumnPass(const int* const* rows, const int width, const int height, const int radius,
+                          QImage& output)
+{
+    using Traits = PixelTraits<Pixel>;
+
+    const int area = (2*radius+1)*(2*radius+1);
+    const int count = Traits::Channels*width;
+    uchar* const outputBits = output.bits();
+    const int outputStride = output.bytesPerLine();
+    parallelForRows(height,count*sizeof(int),[&](int begin, int end){
+        QVector<int> columnSum(count,0);
+        int* sum = columnSum.data();
+        for (int i=begin; i<begin+2*radius; ++i)
+        {
+            for (int c=0; c<count; ++c)
             {
-                for (int j=0; j<kerCols; ++j)
+                sum[c] += rows[i][c];
+            }
+        }
+        for (int y=begin; y<end; ++y)
+        {
+            const int* entering = rows[y+2*radius];
+            const int* leaving = rows[y];
+            Pixel* line = reinterpret_cast<Pixel*>(outputBits+y*outputStride);
+            for (int x=0; x<width; ++x)
+            {
+                int channels[Traits::Channels];
+                for (int c=0; c<Traits::Channels; ++c)
                 {
-                    MAYBE_INTERRUPT();
-
-                    const QRgb pix = image.valid(x+j-kerCenterX,y+i-kerCenterY)
-                                    ? image.pixel(x+j-kerCenterX,y+i-kerCenterY)
-                                    : padding;
-                    const auto kerXVar = kerX.at(kerRows-1-i,kerCols-1-j);
-                    const auto kerYVar = kerY.at(kerRows-1-i,kerCols-1-j);
-                    rx += qRed(pix)*kerXVar;
-                    gx += qGreen(pix)*kerXVar;
-                    bx += qBlue(pix)*kerXVar;
-                    ry += qRed(pix)*kerYVar;
-                    gy += qGreen(pix)*kerYVar;
-                    by += qBlue(pix)*kerYVar;
+                    channels[c] = (sum[Traits::Channels*x+c] += entering[Traits::Channels*x+c])/area;
                 }
+                line[x] = Traits::pixel(channels);
+            }
+            for (int c=0; c<count; ++c)
+            {
+                sum[c] -= leaving[c];
+            }
+        }
+    },0.5,1);
+}
+
+/*!
+    \internal
+ */
+template<typename Pixel>
+static QImage boxFilter_Impl(const QImage& image, uint radius, PaddingType padding)
+{
+    using Traits = PixelTraits<Pixel>;
+
+    QImage output(image.size(),Traits::format());
+    const QImage input = image.convertToFormat(Traits::format());
+
+    const int width = image.width();
+    const int height = image.height();
+    const int count = Traits::Channels*width;
+    const int r = radius;
+    const QVector<int> indicesX = paddingIndices(width,r,padding);
+    const QVector<int> indicesY = paddingIndices(height,r,padding);
+
+    QVector<int> buffer(count*height);
+    parallelForRows(height,input.bytesPerLine(),[&](int begin, int end){
+        QVector<Pixel> extLine(width+2*r);
+        for (int y=begin; y<end; ++y)
+        {
+            const Pixel* iLine = reinterpret_cast<const Pixel*>(input.constScanLine(y));
+            for (int x=0; x<extLine.size(); ++x)
+            {
+                extLine[x] = iLine[indicesX.at(x)];
             }
-            line[x] = qRgb(qBound(0,static_cast<int>(hypot(rx,ry)),0xff),
-                           qBound(0,static_cast<int>(hypot(gx,gy)),0xff),
-                           qBound(0,static_cast<int>(hypot(bx,by)),0xff));
+            boxRowPass(extLine.constData(),width,r,buffer.data()+count*y);
         }
+    },0,0.5);
+    MAYBE_INTERRUPT();
 
-        PROGRESS_UPDATE(y/height);
+    QVector<const int*> rows(height+2*r);
+    for (int i=0; i<rows.size(); ++i)
+    {
+        rows[i] = buffer.constData()+count*indicesY.at(i);
     }
+    boxColumnPass<Pixel>(rows.constData(),width,height,r,output);
+    MAYBE_INTERRUPT();
 
     return output.convertToFormat(image.format());
 }
 
 /*!
-    \overload convolveXY
-
-    Convolve the \a image with kernel \a kerX & \b kerY, using specified padding color \a padding,
-    and then combine the two.
+    \internal
  */
-QImage convolveXY(const QImage& image, const MatrixKernel& kerX, const MatrixKernel& kerY, const QColor& padding)
+template<typename Pixel>
+static QImage boxFilter_Impl(const QImage& image, uint radius, Pixel padding)
 {
-    return convolveXY(image,kerX,kerY,padding.rgb());
+    using Traits = PixelTraits<Pixel>;
+
+    QImage output(image.size(),Traits::format());
+    const QImage input = image.convertToFormat(Traits::format());
+
+    const int width = image.width();
+    const int height = image.height();
+    const int count = Traits::Channels*width;
+    const int r = radius;
+
+    QVector<int> buffer(count*height);
+    parallelForRows(height,input.bytesPerLine(),[&](int begin, int end){
+        QVector<Pixel> extLine(width+2*r,padding);
+        for (int y=begin; y<end; ++y)
+        {
+            const Pixel* iLine = reinterpret_cast<const Pixel*>(input.constScanLine(y));
+            ::std::copy(iLine,iLine+width,extLine.begin()+r);
+            boxRowPass(extLine.constData(),width,r,buffer.data()+count*y);
+        }
+    },0,0.5);
+    MAYBE_INTERRUPT();
+
+    // the rows beyond the image are filled with padding color entirely
+    QVector<int> paddingRow(count);
+    const QVector<Pixel> paddingLine(width+2*r,padding);
+    boxRowPass(paddingLine.constData(),width,r,paddingRow.data());
+
+    QVector<const int*> rows(height+2*r);
+    for (int i=0; i<rows.size(); ++i)
+    {
+        const int yy = i-r;
+        rows[i] = yy>=0 && yy<height ? buffer.constData()+count*yy
+                                     : paddingRow.constData();
+    }
+    boxColumnPass<Pixel>(rows.constData(),width,height,r,output);
+    MAYBE_INTERRUPT();
+
+    return output.convertToFormat(image.format());
 }
 
 /*!
     Filter \a image by convolving with a box kernel of \a radius.
 
     Every element of a box kernel is same, and the sum of the elements is 1.
+
+    The window sums are maintained incrementally, so the cost per pixel does not depend on \a radius.
  */
 QImage boxFilter(const QImage& image, uint radius, PaddingType padding)
 {
-    MatrixKernel boxKer(2*radius+1,2*radius+1,
-                        1./(2*radius+1)/(2*radius+1));
-    return convolve(image,boxKer,padding);
+    return image.allGray() ? boxFilter_Impl<uchar>(image,radius,padding)
+                           : boxFilter_Impl<QRgb>(image,radius,padding);
 }
 
 /*!
@@ -485,9 +2139,9 @@ QImage boxFilter(const QImage& image, uint radius, PaddingType padding)
  */
 QImage boxFilter(const QImage& image, uint radius, QRgb padding)
 {
-    MatrixKernel boxKer(2*radius+1,2*radius+1,
-                        1./(2*radius+1)/(2*radius+1));
-    return convolve(image,boxKer,padding);
+    return image.allGray() && qIsGray(padding)
+            ? boxFilter_Impl<uchar>(image,radius,static_cast<uchar>(qGray(padding)))
+            : boxFilter_Impl<QRgb>(image,radius,padding);
 }
 
 /*!
@@ -495,145 +2149,682 @@ QImage boxFilter(const QImage& image, uint radius, QRgb padding)
  */
 QImage boxFilter(const QImage& image, uint radius, const QColor& padding)
 {
-    MatrixKernel boxKer(2*radius+1,2*radius+1,
-                        1./(2*radius+1)/(2*radius+1));
-    return convolve(image,boxKer,padding);
+    return boxFilter(image,radius,padding.rgb());
+}
+
+/*!
+    \internal
+
+    The means of \a data, which has \a width x \a height values, in a range \a radius window.
+    The window is cut at the borders and the mean is taken over the values inside only.
+
+    Like boxFilter(), the window sums are maintained incrementally.
+ */
+static QVector<qreal> boxMean(const QVector<qreal>& data, const int width, const int height, const int radius)
+{
+    const int r = radius;
+
+    QVector<qreal> rows(width*height);
+    parallelForRows(height,width*sizeof(qreal),[&](int begin, int end){
+        for (int y=begin; y<end; ++y)
+        {
+            const qreal* dLine = data.constData()+width*y;
+            qreal* line = rows.data()+width*y;
+            qreal sum = 0;
+            for (int x=0; x<r && x<width; ++x)
+            {
+                sum += dLine[x];
+            }
+            for (int x=0; x<width; ++x)
+            {
+                if (x+r<width)
+                    sum += dLine[x+r];
+                line[x] = sum;
+                if (x-r>=0)
+                    sum -= dLine[x-r];
+            }
+        }
+    },0,0);
+
+    QVector<qreal> means(width*height);
+    parallelForRows(height,width*sizeof(qreal),[&](int begin, int end){
+        QVector<qreal> columnSum(width,0);
+        const auto updateWindow = [&](int yy, int sign) {
+            const qreal* rLine = rows.constData()+width*yy;
+            for (int x=0; x<width; ++x)
+            {
+                columnSum[x] += sign*rLine[x];
+            }
+        };
+
+        for (int yy=qMax(0,begin-r); yy<begin+r && yy<height; ++yy)
+        {
+            updateWindow(yy,1);
+        }
+        for (int y=begin; y<end; ++y)
+        {
+            if (y+r<height)
+                updateWindow(y+r,1);
+            const int rowCount = qMin(height-1,y+r)-qMax(0,y-r)+1;
+            qreal* line = means.data()+width*y;
+            for (int x=0; x<width; ++x)
+            {
+                const int count = rowCount*(qMin(width-1,x+r)-qMax(0,x-r)+1);
+                line[x] = columnSum.at(x)/count;
+            }
+            if (y-r>=0)
+                updateWindow(y-r,-1);
+        }
+    },0,0);
+
+    return means;
+}
+
+/*!
+    Filter the grayscale of \a image by the guided filter, using itself as the guide.
+
+    Each window of \a radius fits the output as a linear function of the input, whose slope
+    is var/(var+\a epsilon) with the variance var of the window. So the flat regions, where var is small
+    compared to \a epsilon, are smoothed, while the edges, where var is large, are kept.
+    The intensities are scaled to [0, 1] for \a epsilon.
+    A window of zero variance keeps its mean, so a zero \a epsilon leaves the image unchanged,
+    and a negative one is taken as zero.
+
+    It is built from box means only, so the cost per pixel does not depend on \a radius.
+
+    \quotation
+    He, K, Sun, J & Tang, X (2013), "Guided image filtering",
+    IEEE Trans. Pattern Analysis and Machine Intelligence 35(6): 1397-1409, doi:10.1109/TPAMI.2012.213
+    \endquotation
+ */
+QImage guidedFilter(const QImage& image, uint radius, qreal epsilon)
+{
+    const QImage input = image.convertToFormat(QImage::Format_Grayscale8);
+    const int width = image.width();
+    const int height = image.height();
+    const int r = radius;
+    const qreal eps = qMax(epsilon,qreal(0))*0xff*0xff;
+
+    QVector<qreal> values(width*height);
+    QVector<qreal> squares(width*height);
+    for (int y=0; y<height; ++y)
+    {
+        const uchar* iLine = input.constScanLine(y);
+        for (int x=0; x<width; ++x)
+        {
+            values[width*y+x] = iLine[x];
+            squares[width*y+x] = iLine[x]*iLine[x];
+        }
+    }
+    PROGRESS_UPDATE(0.1);
+
+    const QVector<qreal> mean = boxMean(values,width,height,r);
+    const QVector<qreal> meanSquare = boxMean(squares,width,height,r);
+    MAYBE_INTERRUPT();
+    PROGRESS_UPDATE(0.4);
+
+    // the coefficients of q = a*I + b in each window, overwriting the inputs no longer used
+    QVector<qreal>& a = squares;
+    QVector<qreal>& b = values;
+    for (int i=0; i<width*height; ++i)
+    {
+        const qreal variance = qMax(meanSquare.at(i)-mean.at(i)*mean.at(i),qreal(0));
+        a[i] = variance+eps > 0 ? variance/(variance+eps) : 0;
+        b[i] = (1-a.at(i))*mean.at(i);
+    }
+    PROGRESS_UPDATE(0.5);
+
+    const QVector<qreal> meanA = boxMean(a,width,height,r);
+    const QVector<qreal> meanB = boxMean(b,width,height,r);
+    MAYBE_INTERRUPT();
+    PROGRESS_UPDATE(0.9);
+
+    QImage output(image.size(),QImage::Format_Grayscale8);
+    for (int y=0; y<height; ++y)
+    {
+        const uchar* iLine = input.constScanLine(y);
+        uchar* line = output.scanLine(y);
+        for (int x=0; x<width; ++x)
+        {
+            const int i = width*y+x;
+            line[x] = static_cast<uchar>(qBound(0,qRound(meanA.at(i)*iLine[x]+meanB.at(i)),0xff));
+        }
+    }
+
+    return output.convertToFormat(image.format());
 }
 
 /*!
     \internal
 
-    Generate Gaussian kernel with specified \a radius and \a sigma.
+    Generate the row factor of a Gaussian kernel with specified \a radius and \a sigma.
+
+    The 2D Gaussian kernel is the outer product of it and its transpose.
+
+    The recently used kernels are memoized by (\a radius, \a sigma), as the filter
+    is usually run on a sequence of images with the same parameters.
  */
-static inline MatrixKernel gaussianKernel(uint radius, qreal sigma)
+static MatrixKernel gaussianKernel(uint radius, qreal sigma)
 {
-    constexpr qreal PI = 3.14159265358979323846;
+    static QMutex mutex;
+    static QCache<QPair<uint,qreal>,MatrixKernel> cache(32);
 
-    MatrixKernel ker(2*radius+1,2*radius+1,0);
+    const QPair<uint,qreal> key(radius,sigma);
+    QMutexLocker locker(&mutex);
+    if (const MatrixKernel* cached = cache.object(key))
+        return *cached;
+
+    MatrixKernel ker(1,2*radius+1,0);
     const int r = radius;
     const qreal s = 2*sigma*sigma;
     qreal sum = 0;
 
     for (int x=-r; x<=r; ++x)
     {
-        for (int y=-r; y<=r; ++y)
+        sum += ker(0,x+r) = ::std::exp(-x*x/s);
+    }
+    ker /= sum;
+
+    cache.insert(key,new MatrixKernel(ker));
+    return ker;
+}
+
+/*!
+    Filter \a image by convolving with a Gaussian kernel of \a radius.
+
+    Uses the standard deviation σ=radius/2.
+ */
+QImage gaussianFilter(const QImage& image, uint radius, PaddingType padding)
+{
+    return gaussianFilter(image,radius,radius/2.,padding);
+}
+
+/*!
+    \overload gaussianFilter
+
+    Uses a Gaussian kernel with \a radius and standard deviation \a sigma.
+ */
+QImage gaussianFilter(const QImage& image, uint radius, qreal sigma, PaddingType padding)
+{
+    const MatrixKernel ker = gaussianKernel(radius,sigma);
+    return convolveSeparable(image,ker.transposed(),ker,padding);
+}
+
+/*!
+    \overload gaussianFilter
+ */
+QImage gaussianFilter(const QImage& image, uint radius, QRgb padding)
+{
+    return gaussianFilter(image,radius,radius/2.,padding);
+}
+
+/*!
+    \overload gaussianFilter
+ */
+QImage gaussianFilter(const QImage& image, uint radius, qreal sigma, QRgb padding)
+{
+    const MatrixKernel ker = gaussianKernel(radius,sigma);
+    return convolveSeparable(image,ker.transposed(),ker,padding);
+}
+
+/*!
+    \overload gaussianFilter
+ */
+QImage gaussianFilter(const QImage& image, uint radius, const QColor& padding)
+{
+    return gaussianFilter(image,radius,radius/2.,padding);
+}
+
+/*!
+    \overload gaussianFilter
+ */
+QImage gaussianFilter(const QImage& image, uint radius, qreal sigma, const QColor& padding)
+{
+    return gaussianFilter(image,radius,sigma,padding.rgb());
+}
+
+/*!
+    \internal
+
+    Coefficients of the third-order recursive approximation to a Gaussian
+    of Young & van Vliet, together with the matrix of Triggs & Sdika
+    which initializes the anti-causal pass from the end of the causal pass.
+
+    Both passes evaluate y[n] = b*x[n] + a1*y[n∓1] + a2*y[n∓2] + a3*y[n∓3].
+ */
+struct RecursiveGaussian
+{
+    qreal b;
+    qreal a[3];
+    qreal m[3][3];
+
+    explicit RecursiveGaussian(qreal sigma)
+    {
+        // the approximation is only valid for σ≥0.5
+        sigma = qMax(sigma,qreal(0.5));
+        const qreal q = sigma>=2.5 ? 0.98711*sigma-0.96330
+                                   : 3.97156-4.14554*::std::sqrt(1-0.26891*sigma);
+        const qreal q2 = q*q;
+        const qreal q3 = q2*q;
+        const qreal b0 = 1.57825+2.44413*q+1.4281*q2+0.422205*q3;
+        a[0] = (2.44413*q+2.85619*q2+1.26661*q3)/b0;
+        a[1] = -(1.4281*q2+1.26661*q3)/b0;
+        a[2] = 0.422205*q3/b0;
+        b = 1-(a[0]+a[1]+a[2]);
+
+        // the matrix maps the deviations from the steady state of an unscaled filter,
+        // so it is scaled by the gain b as well
+        const qreal a1 = a[0];
+        const qreal a2 = a[1];
+        const qreal a3 = a[2];
+        const qreal scale = b/((1+a1-a2+a3)*(1-a1-a2-a3)*(1+a2+(a1-a3)*a3));
+        m[0][0] = scale*(-a3*a1+1-a3*a3-a2);
+        m[0][1] = scale*(a3+a1)*(a2+a3*a1);
+        m[0][2] = scale*a3*(a1+a3*a2);
+        m[1][0] = scale*(a1+a3*a2);
+        m[1][1] = -scale*(a2-1)*(a2+a3*a1);
+        m[1][2] = -scale*a3*(a3*a1+a3*a3+a2-1);
+        m[2][0] = scale*(a3*a1+a2+a1*a1-a2*a2);
+        m[2][1] = scale*(a1*a2+a3*a2*a2-a1*a3*a3-a3*a3*a3-a3*a2+a3);
+        m[2][2] = scale*a3*(a1+a3*a2);
+    }
+};
+
+/*!
+    \internal
+
+    Smooth \a lanes independent signals of \a length samples in place, with the causal
+    and then the anti-causal pass of the recursive Gaussian \a g.
+    The sample \c i of lane \c l is at \c data[i*step+l], so the lanes are processed together.
+
+    The signals are extended by the constant \a padding (one value for each lane),
+    or by repetitions of their end samples if \a padding is null.
+ */
+static void recursiveGaussianPass(qreal* data, const int length, const int step, const int lanes,
+                                  const RecursiveGaussian& g, const qreal* padding)
+{
+    if (length <= 0)
+        return;
+
+    // the steady states before the begin and after the end, and the anti-causal outputs after the end
+    QVector<qreal> scratch(4*lanes);
+    qreal* const before = scratch.data();
+    qreal* const after = before+lanes;
+    qreal* const tail = after+lanes;
+    qreal* const last = data+(length-1)*step;
+    ::std::copy(padding ? padding : data,(padding ? padding : data)+lanes,before);
+    ::std::copy(padding ? padding : last,(padding ? padding : last)+lanes,after);
+
+    const qreal b = g.b;
+    const qreal a1 = g.a[0];
+    const qreal a2 = g.a[1];
+    const qreal a3 = g.a[2];
+
+    // the unity DC gain makes the steady state of a constant extension that constant
+    auto causal = [=](int i)->const qreal*{
+        return i>=0 ? data+i*step : before;
+    };
+    for (int n=0; n<length; ++n)
+    {
+        qreal* line = data+n*step;
+        const qreal* y1 = causal(n-1);
+        const qreal* y2 = causal(n-2);
+        const qreal* y3 = causal(n-3);
+        for (int l=0; l<lanes; ++l)
+        {
+            line[l] = b*line[l]+a1*y1[l]+a2*y2[l]+a3*y3[l];
+        }
+    }
+
+    const qreal* w1 = causal(length-2);
+    const qreal* w2 = causal(length-3);
+    for (int l=0; l<lanes; ++l)
+    {
+        const qreal u = after[l];
+        const qreal d0 = last[l]-u;
+        const qreal d1 = w1[l]-u;
+        const qreal d2 = w2[l]-u;
+        last[l] = g.m[0][0]*d0+g.m[0][1]*d1+g.m[0][2]*d2+u;
+        tail[l] = g.m[1][0]*d0+g.m[1][1]*d1+g.m[1][2]*d2+u;
+        tail[lanes+l] = g.m[2][0]*d0+g.m[2][1]*d1+g.m[2][2]*d2+u;
+    }
+
+    auto antiCausal = [=](int i)->const qreal*{
+        return i<length ? data+i*step : tail+(i-length)*lanes;
+    };
+    for (int n=length-2; n>=0; --n)
+    {
+        qreal* line = data+n*step;
+        const qreal* y1 = antiCausal(n+1);
+        const qreal* y2 = antiCausal(n+2);
+        const qreal* y3 = antiCausal(n+3);
+        for (int l=0; l<lanes; ++l)
+        {
+            line[l] = b*line[l]+a1*y1[l]+a2*y2[l]+a3*y3[l];
+        }
+    }
+}
+
+/*!
+    \internal
+
+    The recursive Gaussian filter. Extends the image by repetitions of the edge pixels
+    if \a padding is null, or by the color \a padding otherwise.
+ */
+template<typename Pixel>
+static QImage recursiveGaussianFilter_Impl(const QImage& image, qreal sigma, const Pixel* padding)
+{
+    using Traits = PixelTraits<Pixel>;
+
+    QImage output(image.size(),Traits::format());
+    const QImage input = image.convertToFormat(Traits::format());
+
+    const int width = image.width();
+    const int height = image.height();
+    const int count = Traits::Channels*width;
+    const RecursiveGaussian g(sigma);
+
+    QVector<qreal> paddingLine;
+    if (padding)
+    {
+        paddingLine.resize(count);
+        for (int i=0; i<count; ++i)
+        {
+            paddingLine[i] = Traits::channel(*padding,i%Traits::Channels);
+        }
+    }
+    const qreal* const paddingData = padding ? paddingLine.constData() : nullptr;
+
+    QVector<qreal> buffer(count*height);
+    parallelForRows(height,input.bytesPerLine(),[&](int begin, int end){
+        for (int y=begin; y<end; ++y)
         {
-            sum += ker(x+r,y+r) = ::std::exp(-(x*x+y*y)/s)/s/PI;
+            const Pixel* iLine = reinterpret_cast<const Pixel*>(input.constScanLine(y));
+            qreal* line = buffer.data()+count*y;
+            for (int x=0; x<width; ++x)
+            {
+                for (int c=0; c<Traits::Channels; ++c)
+                {
+                    line[Traits::Channels*x+c] = Traits::channel(iLine[x],c);
+                }
+            }
+            recursiveGaussianPass(line,width,Traits::Channels,Traits::Channels,g,paddingData);
         }
-    }
+    },0,0.5);
+    MAYBE_INTERRUPT();
+
+    // every band of columns runs down the whole image, so that the rows are read contiguously
+    uchar* const outputBits = output.bits();
+    const int outputStride = output.bytesPerLine();
+    parallelForRows(width,height*Traits::Channels*sizeof(qreal),[&](int begin, int end){
+        qreal* const columns = buffer.data()+Traits::Channels*begin;
+        recursiveGaussianPass(columns,height,count,Traits::Channels*(end-begin),g,paddingData);
+        for (int y=0; y<height; ++y)
+        {
+            const qreal* line = buffer.constData()+count*y;
+            Pixel* oLine = reinterpret_cast<Pixel*>(outputBits+y*outputStride);
+            for (int x=begin; x<end; ++x)
+            {
+                int channels[Traits::Channels];
+                for (int c=0; c<Traits::Channels; ++c)
+                {
+                    channels[c] = qBound(0,static_cast<int>(line[Traits::Channels*x+c]),0xff);
+                }
+                oLine[x] = Traits::pixel(channels);
+            }
+        }
+    },0.5,1);
+    MAYBE_INTERRUPT();
 
-    return ker/sum;
+    return output.convertToFormat(image.format());
 }
 
 /*!
-    Filter \a image by convolving with a Gaussian kernel of \a radius.
+    Filter \a image by a recursive (IIR) approximation to the Gaussian of standard deviation \a sigma.
 
-    Uses the standard deviation σ=radius/2.
- */
-QImage gaussianFilter(const QImage& image, uint radius, PaddingType padding)
-{
-    return gaussianFilter(image,radius,radius/2.,padding);
-}
+    Uses the third-order recursive filter of Young & van Vliet along the rows and then the columns,
+    so the cost per pixel does not depend on \a sigma, unlike gaussianFilter() whose radius grows with it.
+    The approximation holds for σ≥0.5, and a smaller \a sigma is treated as 0.5.
 
-/*!
-    \overload gaussianFilter
+    The image is extended by repetitions of the edge pixels, as PaddingType::Fixed,
+    which the boundary conditions of Triggs & Sdika handle exactly.
 
-    Uses a Gaussian kernel with \a radius and standard deviation \a sigma.
- */
-QImage gaussianFilter(const QImage& image, uint radius, qreal sigma, PaddingType padding)
-{
-    return convolve(image,gaussianKernel(radius,sigma),padding);
-}
+    \quotation
+    Young, I T & van Vliet, L J (1995), "Recursive implementation of the Gaussian filter",
+    Signal Processing 44(2): 139-151, doi:10.1016/0165-1684(95)00020-E
+    \endquotation
+    \quotation
+    Triggs, B & Sdika, M (2006), "Boundary conditions for Young-van Vliet recursive filtering",
+    IEEE Trans. Signal Processing 54(6): 2365-2367, doi:10.1109/TSP.2006.871980
+    \endquotation
 
-/*!
-    \overload gaussianFilter
+    \sa gaussianFilter()
  */
-QImage gaussianFilter(const QImage& image, uint radius, QRgb padding)
+QImage recursiveGaussianFilter(const QImage& image, qreal sigma)
 {
-    return gaussianFilter(image,radius,radius/2.,padding);
+    return image.allGray() ? recursiveGaussianFilter_Impl<uchar>(image,sigma,nullptr)
+                           : recursiveGaussianFilter_Impl<QRgb>(image,sigma,nullptr);
 }
 
 /*!
-    \overload gaussianFilter
- */
-QImage gaussianFilter(const QImage& image, uint radius, qreal sigma, QRgb padding)
-{
-    return convolve(image,gaussianKernel(radius,sigma),padding);
-}
+    \overload recursiveGaussianFilter
 
-/*!
-    \overload gaussianFilter
+    The image is extended by the color \a padding.
  */
-QImage gaussianFilter(const QImage& image, uint radius, const QColor& padding)
+QImage recursiveGaussianFilter(const QImage& image, qreal sigma, QRgb padding)
 {
-    return gaussianFilter(image,radius,radius/2.,padding);
+    if (image.allGray() && qIsGray(padding))
+    {
+        const uchar gray = static_cast<uchar>(qGray(padding));
+        return recursiveGaussianFilter_Impl<uchar>(image,sigma,&gray);
+    }
+    return recursiveGaussianFilter_Impl<QRgb>(image,sigma,&padding);
 }
 
 /*!
-    \overload gaussianFilter
+    \overload recursiveGaussianFilter
  */
-QImage gaussianFilter(const QImage& image, uint radius, qreal sigma, const QColor& padding)
+QImage recursiveGaussianFilter(const QImage& image, qreal sigma, const QColor& padding)
 {
-    return convolve(image,gaussianKernel(radius,sigma),padding);
+    return recursiveGaussianFilter(image,sigma,padding.rgb());
 }
 
 /*!
     \internal
 
     when the orgin image is grayscale.
+
+    Uses the constant-time median filtering of Perreault & Hébert:
+    a histogram is kept for every column of the window rows, and the
+    histogram of the window is updated by adding and subtracting column
+    histograms as it slides, so the cost per pixel does not depend on \a radius.
+    Every histogram is split into a coarse level of 16 bins and a fine level of 256 bins.
+    Only the coarse level of the window follows every step; a 16-bin segment of the fine
+    level is brought up to date when the median falls into it, which mostly happens to
+    the same one or two segments, so finding the median needs only 32 steps.
+    For small windows, the pixels of the entering and leaving columns are visited
+    directly instead, which is cheaper than adding whole histograms.
  */
 static QImage medianFilter_Grayscale(const QImage& image, uint radius)
 {
+/*!
+    \quotation
+    Perreault, S & Hébert, P (2007), "Median Filtering in Constant Time",
+    IEEE Trans. Image Processing 16(9): 2389-2394, doi:10.1109/TIP.2007.902329
+    \endquotation
+ */
+
     Q_ASSUME(image.isGrayscale());
 
+    constexpr int Bins = 0x100;
+    constexpr int CoarseBins = 0x10;
+    constexpr int CoarseShift = 4;
+    constexpr int DirectUpdateLimit = 12;
+
     QImage output(image.size(),QImage::Format_Grayscale8);
     const QImage input = image.convertToFormat(QImage::Format_Grayscale8);
-    QVector<uint> histogram(0x100,0);
 
     const int width = image.width();
     const int height = image.height();
     const int r = radius;
+    uchar* const outputBits = output.bits();
+    const int outputStride = output.bytesPerLine();
+
+    // the median of a window, where refine(c) brings the segment c of fine up to date
+    const auto findMedian = [](const uint* coarse, const uint* fine, uint sum, auto refine) {
+        uint partSum = 0;
+        int c = 0;
+        while (partSum+coarse[c]<sum/2 && c<CoarseBins-1)
+        {
+            partSum += coarse[c];
+            ++c;
+        }
+        refine(c);
+        int i = c<<CoarseShift;
+        for (; i<((c+1)<<CoarseShift)-1; ++i)
+        {
+            partSum += fine[i];
+            if (partSum>=sum/2)
+                break;
+        }
+        return static_cast<uchar>(i);
+    };
 
-    for (int y=0; y<height; ++y)
+    if (2*r+1 < DirectUpdateLimit)
     {
-        uchar* line = output.scanLine(y);
-        for (int x=0; x<width; ++x)
-        {
-            uint sum = 0;
-            histogram.fill(0);
-            for (int i=-r; i<=r; ++i)
+        // cheaper to visit the pixels of the entering and leaving columns than their histograms
+        parallelForRows(height,input.bytesPerLine(),[&](int begin, int end){
+            uint fine[Bins];
+            uint coarse[CoarseBins];
+            for (int y=begin; y<end; ++y)
             {
-                const int yy = y+i;
-                if (yy<0 || yy>=height)
-                    continue;
-                const uchar* iLine = input.constScanLine(yy);
-                for (int j=-r; j<=r; ++j)
+                const int top = qMax(0,y-r);
+                const int bottom = qMin(height-1,y+r);
+                const uint rows = bottom-top+1;
+                const auto updateWindow = [&](int xx, int delta) {
+                    for (int yy=top; yy<=bottom; ++yy)
+                    {
+                        const uchar value = input.constScanLine(yy)[xx];
+                        fine[value] += delta;
+                        coarse[value>>CoarseShift] += delta;
+                    }
+                };
+
+                ::std::fill_n(fine,Bins,0u);
+                ::std::fill_n(coarse,CoarseBins,0u);
+                for (int xx=0; xx<r && xx<width; ++xx)
                 {
-                    MAYBE_INTERRUPT();
+                    updateWindow(xx,1);
+                }
 
-                    const int xx = x+j;
-                    if (xx<0 || xx>=width)
-                        continue;
-                    ++histogram[iLine[xx]];
-                    ++sum;
+                uchar* line = outputBits+y*outputStride;
+                for (int x=0; x<width; ++x)
+                {
+                    if (x+r<width)
+                        updateWindow(x+r,1);
+                    if (x-r-1>=0)
+                        updateWindow(x-r-1,-1);
+                    const uint sum = rows*(qMin(width-1,x+r)-qMax(0,x-r)+1);
+                    line[x] = findMedian(coarse,fine,sum,[](int){});
+                }
+            }
+        });
+        MAYBE_INTERRUPT();
+
+        return output.convertToFormat(image.format());
+    }
+
+    // every band first fills the column histograms of the 2r+1 rows above it,
+    // so it is made a few times taller than that
+    parallelForRows(height,input.bytesPerLine(),[&](int begin, int end){
+        // histograms of every column within the rows of the window
+        QVector<quint16> columnFine(width*Bins,0);
+        QVector<quint16> columnCoarse(width*CoarseBins,0);
+        const auto updateColumns = [&](int yy, int delta) {
+            const uchar* iLine = input.constScanLine(yy);
+            for (int x=0; x<width; ++x)
+            {
+                columnFine[x*Bins+iLine[x]] += delta;
+                columnCoarse[x*CoarseBins+(iLine[x]>>CoarseShift)] += delta;
+            }
+        };
+        const quint16* const columnFineBits = columnFine.constData();
+        const quint16* const columnCoarseBits = columnCoarse.constData();
+
+        // histogram of the window; a segment of the fine level is only brought up to date
+        // when the median falls into it, and refreshed[c] is the x it was last updated for
+        uint fine[Bins];
+        uint coarse[CoarseBins];
+        int refreshed[CoarseBins];
+        const auto addSegment = [&](int c, int column, int delta) {
+            const quint16* columnBits = columnFineBits+column*Bins+(c<<CoarseShift);
+            uint* fineBits = fine+(c<<CoarseShift);
+            for (int i=0; i<CoarseBins; ++i)
+            {
+                fineBits[i] += delta*columnBits[i];
+            }
+        };
+
+        for (int yy=qMax(0,begin-r-1); yy<begin+r && yy<height; ++yy)
+        {
+            updateColumns(yy,1);
+        }
+
+        for (int y=begin; y<end; ++y)
+        {
+            if (y+r<height)
+                updateColumns(y+r,1);
+            if (y-r-1>=0)
+                updateColumns(y-r-1,-1);
+            const uint rows = qMin(height-1,y+r)-qMax(0,y-r)+1;
+
+            ::std::fill_n(coarse,CoarseBins,0u);
+            ::std::fill_n(refreshed,CoarseBins,::std::numeric_limits<int>::min()/2);
+            for (int xx=0; xx<r && xx<width; ++xx)
+            {
+                for (int i=0; i<CoarseBins; ++i)
+                {
+                    coarse[i] += columnCoarseBits[xx*CoarseBins+i];
                 }
             }
 
-            // find median
-            uint partSum = 0;
-            for (uint i=0; i<0x100;++i)
+            uchar* line = outputBits+y*outputStride;
+            for (int x=0; x<width; ++x)
             {
-                partSum += histogram.at(i);
-                if (partSum>=sum/2)
+                const quint16* entering = x+r<width ? columnCoarseBits+(x+r)*CoarseBins : nullptr;
+                const quint16* leaving = x-r-1>=0 ? columnCoarseBits+(x-r-1)*CoarseBins : nullptr;
+                for (int i=0; i<CoarseBins; ++i)
                 {
-                    line[x] = i;
-                    break;
+                    coarse[i] += (entering ? entering[i] : 0) - (leaving ? leaving[i] : 0);
                 }
+                const uint sum = rows*(qMin(width-1,x+r)-qMax(0,x-r)+1);
+
+                line[x] = findMedian(coarse,fine,sum,[&](int c) {
+                    if (x-refreshed[c] > r)
+                    {
+                        // rebuilding from the columns of the window is cheaper
+                        ::std::fill_n(fine+(c<<CoarseShift),CoarseBins,0u);
+                        for (int xx=qMax(0,x-r); xx<=qMin(width-1,x+r); ++xx)
+                        {
+                            addSegment(c,xx,1);
+                        }
+                    }
+                    else
+                    {
+                        for (int xx=refreshed[c]+1; xx<=x; ++xx)
+                        {
+                            if (xx+r<width)
+                                addSegment(c,xx+r,1);
+                            if (xx-r-1>=0)
+                                addSegment(c,xx-r-1,-1);
+                        }
+                    }
+                    refreshed[c] = x;
+                });
             }
         }
-
-        PROGRESS_UPDATE(y/height);
-    }
+    },0,1,4*r);
+    MAYBE_INTERRUPT();
 
     return output.convertToFormat(image.format());
 }
@@ -641,208 +2832,678 @@ static QImage medianFilter_Grayscale(const QImage& image, uint radius)
 /*!
     \internal
 
-    when the radius is small, and the orgin image is not grayscale.
+    when the orgin image is not grayscale.
+
+    The pixels are ordered by their gray levels. The window keeps a histogram of gray levels,
+    along with the last pixel that entered each bin, and is updated incrementally as it slides.
+    The pixels of the leaving column are always the oldest ones of their bins, so the last
+    pixel of a bin stays in the window as long as the bin is not empty, and the median is
+    that pixel of the median bin.
  */
-static QImage medianFilter_ColorSmall(const QImage& image, uint radius)
+static QImage medianFilter_Color(const QImage& image, uint radius)
 {
+    constexpr int Bins = 0x100;
+    constexpr int CoarseBins = 0x10;
+    constexpr int CoarseShift = 4;
+
     QImage output(image.size(),QImage::Format_RGB32);
     const QImage input = image.convertToFormat(QImage::Format_RGB32);
-    QVector<QRgb> medianCandidate;
-    medianCandidate.reserve(((2*radius+1)*(2*radius+1))); // almost
 
     const int width = image.width();
     const int height = image.height();
     const int r = radius;
 
+    // the gray levels are used as keys of the pixels many times
+    QVector<uchar> grayPlane(width*height);
     for (int y=0; y<height; ++y)
     {
-        QRgb* line = reinterpret_cast<QRgb*>(output.scanLine(y));
+        const QRgb* iLine = reinterpret_cast<const QRgb*>(input.constScanLine(y));
+        uchar* gLine = grayPlane.data()+width*y;
         for (int x=0; x<width; ++x)
         {
-            for (int i=-r; i<=r; ++i)
-            {
-                const int yy = y+i;
-                if (yy<0 || yy>=height)
-                    continue;
-                const QRgb* iLine = reinterpret_cast<const QRgb*>(input.constScanLine(yy));
-                for (int j=-r; j<=r; ++j)
-                {
-                    MAYBE_INTERRUPT();
+            gLine[x] = qGray(iLine[x]);
+        }
+    }
 
-                    const int xx = x+j;
-                    if (xx<0 || xx>=width)
-                        continue;
-                    medianCandidate.append(iLine[xx]);
+    uchar* const outputBits = output.bits();
+    const int outputStride = output.bytesPerLine();
+    parallelForRows(height,input.bytesPerLine(),[&](int begin, int end){
+        uint fine[Bins];
+        uint coarse[CoarseBins];
+        QRgb latest[Bins];
+
+        for (int y=begin; y<end; ++y)
+        {
+            const int top = qMax(0,y-r);
+            const int bottom = qMin(height-1,y+r);
+            const uint rows = bottom-top+1;
+            const auto updateWindow = [&](int xx, int delta) {
+                for (int yy=top; yy<=bottom; ++yy)
+                {
+                    const QRgb pix = reinterpret_cast<const QRgb*>(input.constScanLine(yy))[xx];
+                    const uchar key = grayPlane.at(width*yy+xx);
+                    fine[key] += delta;
+                    coarse[key>>CoarseShift] += delta;
+                    if (delta > 0)
+                        latest[key] = pix;
                 }
+            };
+
+            ::std::fill_n(fine,Bins,0u);
+            ::std::fill_n(coarse,CoarseBins,0u);
+            for (int xx=0; xx<r && xx<width; ++xx)
+            {
+                updateWindow(xx,1);
             }
 
-            // find median
-            ::std::size_t medianIndex = medianCandidate.length()/2;
-            ::std::nth_element(medianCandidate.begin(),
-                               medianCandidate.begin()+medianIndex,
-                               medianCandidate.end(),
-                               [](QRgb a, QRgb b){
-                return qGray(a) < qGray(b);
-            });
-            line[x] = medianCandidate.at(medianIndex);
-            medianCandidate.clear();
+            QRgb* line = reinterpret_cast<QRgb*>(outputBits+y*outputStride);
+            for (int x=0; x<width; ++x)
+            {
+                if (x+r<width)
+                    updateWindow(x+r,1);
+                if (x-r-1>=0)
+                    updateWindow(x-r-1,-1);
+                const uint sum = rows*(qMin(width-1,x+r)-qMax(0,x-r)+1);
+
+                // find median
+                uint partSum = 0;
+                int c = 0;
+                while (partSum+coarse[c]<=sum/2)
+                {
+                    partSum += coarse[c];
+                    ++c;
+                }
+                int i = c<<CoarseShift;
+                while (partSum+fine[i]<=sum/2)
+                {
+                    partSum += fine[i];
+                    ++i;
+                }
+                line[x] = latest[i];
+            }
         }
-
-        PROGRESS_UPDATE(y/height);
-    }
+    });
+    MAYBE_INTERRUPT();
 
     return output.convertToFormat(image.format());
 }
 
+/*!
+    Filter \a image by replacing every value by the median in its range \a radius neighborhood.
+ */
+QImage medianFilter(const QImage& image, uint radius)
+{
+    return image.isGrayscale()
+            ? medianFilter_Grayscale(image,radius)
+            : medianFilter_Color(image,radius);
+}
+
 /*!
     \internal
 
-    when the radius is large, and the orgin image is not grayscale.
+    The gray level of \a pixel, which decides the range of mean shift.
  */
-static QImage medianFilter_ColorLarge(const QImage& image, uint radius)
+static inline uchar grayLevel(QRgb pixel)
 {
-    QImage output(image.size(),QImage::Format_RGB32);
-    const QImage input = image.convertToFormat(QImage::Format_RGB32);
-    QVector<QVector<QRgb>> histogram(0x100);
-    for (auto& pixels : histogram)
+    return static_cast<uchar>(qGray(pixel));
+}
+
+/*!
+    \internal
+ */
+static inline uchar grayLevel(uchar pixel)
+{
+    return pixel;
+}
+
+/*!
+    \internal
+
+    The largest difference between the channels of \a a and \a b.
+ */
+template<typename Pixel>
+static inline int channelDifference(Pixel a, Pixel b)
+{
+    using Traits = PixelTraits<Pixel>;
+
+    int difference = 0;
+    for (int c=0; c<Traits::Channels; ++c)
     {
-        pixels.reserve(2*radius*radius); // approximation
+        difference = qMax(difference,::std::abs(Traits::channel(a,c)-Traits::channel(b,c)));
     }
+    return difference;
+}
 
-    const int width = image.width();
-    const int height = image.height();
-    const int r = radius;
+/*!
+    \internal
 
-    for (int y=0; y<height; ++y)
-    {
-        QRgb* line = reinterpret_cast<QRgb*>(output.scanLine(y));
-        for (int x=0; x<width; ++x)
+    Mark every pixel within a range \a radius neighborhood of a marked pixel of \a mask,
+    which has \a width x \a height pixels, each either 0 or 1.
+ */
+static QVector<uchar> dilateMask(const QVector<uchar>& mask, const int width, const int height, const int radius)
+{
+    // count the marked pixels in a window sliding along the rows, and then along the columns
+    QVector<uchar> rows(width*height);
+    parallelForRows(height,width,[&](int begin, int end){
+        for (int y=begin; y<end; ++y)
         {
-            uint sum = 0;
-            for (int i=-r; i<=r; ++i)
+            const uchar* mLine = mask.constData()+width*y;
+            uchar* line = rows.data()+width*y;
+            int count = 0;
+            for (int x=0; x<radius && x<width; ++x)
             {
-                const int yy = y+i;
-                if (yy<0 || yy>=height)
-                    continue;
-                const QRgb* iLine = reinterpret_cast<const QRgb*>(input.constScanLine(yy));
-                for (int j=-r; j<=r; ++j)
+                count += mLine[x];
+            }
+            for (int x=0; x<width; ++x)
+            {
+                if (x+radius<width)
+                    count += mLine[x+radius];
+                if (x-radius-1>=0)
+                    count -= mLine[x-radius-1];
+                line[x] = count>0;
+            }
+        }
+    },0,0);
+
+    QVector<uchar> dilated(width*height);
+    parallelForRows(height,width,[&](int begin, int end){
+        QVector<int> counts(width);
+        const auto updateWindow = [&](int yy, int sign) {
+            const uchar* rLine = rows.constData()+width*yy;
+            for (int x=0; x<width; ++x)
+            {
+                counts[x] += sign*rLine[x];
+            }
+        };
+
+        for (int yy=qMax(0,begin-radius-1); yy<begin+radius && yy<height; ++yy)
+        {
+            updateWindow(yy,1);
+        }
+        for (int y=begin; y<end; ++y)
+        {
+            if (y+radius<height)
+                updateWindow(y+radius,1);
+            if (y-radius-1>=0)
+                updateWindow(y-radius-1,-1);
+            uchar* line = dilated.data()+width*y;
+            for (int x=0; x<width; ++x)
+            {
+                line[x] = counts.at(x)>0;
+            }
+        }
+    },0,0);
+
+    return dilated;
+}
+
+/*!
+    \internal
+
+    Shift the \a active pixels of \a image to the mean of the pixels in a range \a spatialRadius neighborhood
+    whose gray level in \a gray differs by at most \a grayRadius, and copy the others, to \a output.
+    Mark the pixels that moved by more than \a tolerance in \a changed.
+
+    If the window is large, a histogram of the window by gray level is slid along each row,
+    so that adding and removing a column replaces summing the whole window.
+ */
+template<typename Pixel>
+static void meanShiftFilter_Impl(const QImage& image, QImage& output, const QVector<uchar>& gray,
+                                 const QVector<uchar>& active, QVector<uchar>& changed,
+                                 const int spatialRadius, const int grayRadius, const int tolerance,
+                                 qreal progressBegin, qreal progressEnd)
+{
+    using Traits = PixelTraits<Pixel>;
+
+    Q_ASSUME(image.format()==Traits::format());
+    Q_ASSUME(output.format()==Traits::format());
+
+    const int width = image.width();
+    const int height = image.height();
+    const int r = spatialRadius;
+    const int diameter = 2*r+1;
+    constexpr int Bins = 0x100;
+    const bool sliding = 2*diameter+2*grayRadius+1 < diameter*diameter;
+
+    const uchar* const inputBits = image.constBits();
+    const int inputStride = image.bytesPerLine();
+    uchar* const outputBits = output.bits();
+    const int outputStride = output.bytesPerLine();
+    parallelForRows(height,inputStride,[&](int begin, int end){
+        QVector<int> counts(sliding ? Bins : 0);
+        QVector<int> sums(sliding ? Traits::Channels*Bins : 0);
+
+        for (int y=begin; y<end; ++y)
+        {
+            const Pixel* iLineCenter = reinterpret_cast<const Pixel*>(inputBits+y*inputStride);
+            const uchar* gLineCenter = gray.constData()+width*y;
+            const uchar* aLine = active.constData()+width*y;
+            uchar* cLine = changed.data()+width*y;
+            Pixel* line = reinterpret_cast<Pixel*>(outputBits+y*outputStride);
+
+            ::std::copy(iLineCenter,iLineCenter+width,line);
+            ::std::fill(cLine,cLine+width,0);
+            int first = 0;
+            while (first<width && !aLine[first])
+                ++first;
+            if (first == width)
+                continue;
+            int last = width-1;
+            while (!aLine[last])
+                --last;
+
+            const int top = qMax(0,y-r);
+            const int bottom = qMin(height-1,y+r);
+            const auto shift = [&](int x, int* channels, int sum) {
+                for (int c=0; c<Traits::Channels; ++c)
                 {
-                    MAYBE_INTERRUPT();
+                    channels[c] /= sum;
+                }
+                line[x] = Traits::pixel(channels);
+                cLine[x] = channelDifference(line[x],iLineCenter[x]) > tolerance;
+            };
 
-                    const int xx = x+j;
-                    if (xx<0 || xx>=width)
+            if (!sliding)
+            {
+                for (int x=first; x<=last; ++x)
+                {
+                    if (!aLine[x])
                         continue;
-                    histogram[qGray(iLine[xx])].append(iLine[xx]);
-                    ++sum;
+                    const int left = qMax(0,x-r);
+                    const int right = qMin(width-1,x+r);
+                    const int center = gLineCenter[x];
+                    int channels[Traits::Channels] = {};
+                    int sum = 0;
+                    for (int yy=top; yy<=bottom; ++yy)
+                    {
+                        const uchar* gLine = gray.constData()+width*yy;
+                        const Pixel* iLine = reinterpret_cast<const Pixel*>(inputBits+yy*inputStride);
+                        for (int xx=left; xx<=right; ++xx)
+                        {
+                            if (::std::abs(gLine[xx]-center) > grayRadius)
+                                continue;
+                            for (int c=0; c<Traits::Channels; ++c)
+                            {
+                                channels[c] += Traits::channel(iLine[xx],c);
+                            }
+                            ++sum;
+                        }
+                    }
+                    shift(x,channels,sum);
                 }
+                continue;
             }
 
-            // find median
-            bool find = false;
-            uint partSum = 0;
-            for (uint i=0; i<0x100;++i)
+            const auto updateWindow = [&](int xx, int sign) {
+                for (int yy=top; yy<=bottom; ++yy)
+                {
+                    const int value = gray.at(width*yy+xx);
+                    const Pixel pixel = reinterpret_cast<const Pixel*>(inputBits+yy*inputStride)[xx];
+                    counts[value] += sign;
+                    for (int c=0; c<Traits::Channels; ++c)
+                    {
+                        sums[Traits::Channels*value+c] += sign*Traits::channel(pixel,c);
+                    }
+                }
+            };
+
+            ::std::fill(counts.begin(),counts.end(),0);
+            ::std::fill(sums.begin(),sums.end(),0);
+            for (int xx=qMax(0,first-r-1); xx<first+r && xx<width; ++xx)
             {
-                const uint nextSum = partSum + histogram.at(i).length();
-                if (nextSum>sum/2 && !find)
+                updateWindow(xx,1);
+            }
+            for (int x=first; x<=last; ++x)
+            {
+                if (x+r<width)
+                    updateWindow(x+r,1);
+                if (x-r-1>=0)
+                    updateWindow(x-r-1,-1);
+                if (!aLine[x])
+                    continue;
+
+                const int center = gLineCenter[x];
+                const int low = qMax(0,center-grayRadius);
+                const int high = qMin(Bins-1,center+grayRadius);
+                int channels[Traits::Channels] = {};
+                int sum = 0;
+                for (int i=low; i<=high; ++i)
                 {
-                    line[x] = histogram.at(i).at(sum/2-partSum);
-                    find = true;
+                    for (int c=0; c<Traits::Channels; ++c)
+                    {
+                        channels[c] += sums.at(Traits::Channels*i+c);
+                    }
+                    sum += counts.at(i);
                 }
-                partSum = nextSum;
-                histogram[i].clear();
+                shift(x,channels,sum);
             }
         }
+    },progressBegin,progressEnd);
+}
+
+/*!
+    \internal
+
+    Shift the pixels of \a image for \a maxLevel levels, or until no pixel moves by more than \a tolerance
+    if \a untilConverged.
+
+    A pixel is shifted again only if a pixel in its neighborhood moved in the previous level,
+    otherwise its window and hence its mean stay the same. So with zero \a tolerance
+    the result is the same as shifting every pixel on every level.
+ */
+template<typename Pixel>
+static QImage meanShiftFilter_Impl(const QImage& image, uint spatialRadius, qreal colorRadius,
+                                   uint maxLevel, int tolerance, bool untilConverged)
+{
+    using Traits = PixelTraits<Pixel>;
+
+    const int width = image.width();
+    const int height = image.height();
+
+    // the largest difference of gray levels within the colorRadius
+    int grayRadius = -1;
+    while (grayRadius<0xff && (grayRadius+1)/qreal(0xff) <= colorRadius)
+        ++grayRadius;
+
+    // shift back and forth between two buffers
+    QImage buffers[2] = {image.convertToFormat(Traits::format()), QImage(image.size(),Traits::format())};
+    QVector<uchar> gray(width*height);
+    for (int y=0; y<height; ++y)
+    {
+        const Pixel* iLine = reinterpret_cast<const Pixel*>(buffers[0].constScanLine(y));
+        ::std::transform(iLine,iLine+width,gray.begin()+width*y,[](Pixel pixel){
+            return grayLevel(pixel);
+        });
+    }
+    QVector<uchar> active(width*height,1);
+    QVector<uchar> changed(width*height);
 
-        PROGRESS_UPDATE(y/height);
+    uint level = 0;
+    while (level < maxLevel)
+    {
+        MAYBE_INTERRUPT();
+
+        // the number of levels is unknown if iterating until converged
+        const qreal progressBegin = untilConverged ? 1-::std::ldexp(1.,-int(level)) : qreal(level)/maxLevel;
+        const qreal progressEnd = untilConverged ? 1-::std::ldexp(1.,-int(level)-1) : qreal(level+1)/maxLevel;
+        const QImage& input = buffers[level%2];
+        QImage& output = buffers[(level+1)%2];
+        meanShiftFilter_Impl<Pixel>(input,output,gray,active,changed,
+                                    spatialRadius,grayRadius,tolerance,progressBegin,progressEnd);
+        ++level;
+        MAYBE_INTERRUPT();
+
+        if (::std::find(changed.cbegin(),changed.cend(),1) == changed.cend())
+            break;
+        for (int y=0; y<height; ++y)
+        {
+            const Pixel* line = reinterpret_cast<const Pixel*>(output.constScanLine(y));
+            const uchar* aLine = active.constData()+width*y;
+            uchar* gLine = gray.data()+width*y;
+            for (int x=0; x<width; ++x)
+            {
+                if (aLine[x])
+                    gLine[x] = grayLevel(line[x]);
+            }
+        }
+        active = dilateMask(changed,width,height,spatialRadius);
     }
+    return buffers[level%2];
+}
+
+/*!
+    Filter \a image by replacing every value by the mean of the pixels
+    in a range \a spatialRadius neighborhood and whose value is within \a colorRadius,
+    repeated \a maxLevel times.
+
+    The pixels whose neighborhood did not change in a level are skipped in the next one.
 
+    \sa meanShiftFilterUntilConverged()
+ */
+QImage meanShiftFilter(const QImage& image, uint spatialRadius, qreal colorRadius, uint maxLevel)
+{
+    const QImage output = image.allGray()
+            ? meanShiftFilter_Impl<uchar>(image,spatialRadius,colorRadius,maxLevel,0,false)
+            : meanShiftFilter_Impl<QRgb>(image,spatialRadius,colorRadius,maxLevel,0,false);
     return output.convertToFormat(image.format());
 }
 
 /*!
-    Filter \a image by replacing every value by the median in its range \a radius neighborhood.
+    Same as meanShiftFilter(), but repeated until no channel moves by more than \a tolerance.
+
+    A pixel that moved by at most \a tolerance is frozen, unless a pixel in its neighborhood moved more.
+    Since the mean is truncated, noisy regions keep drifting down by one level for many levels,
+    so a zero \a tolerance may take far longer to converge.
+    The iteration also stops after 256 levels, in case the rounding makes some pixels oscillate.
  */
-QImage medianFilter(const QImage& image, uint radius)
+QImage meanShiftFilterUntilConverged(const QImage& image, uint spatialRadius, qreal colorRadius, uint tolerance)
 {
-    return image.isGrayscale()
-            ? medianFilter_Grayscale(image,radius)
-            : radius<10
-              ? medianFilter_ColorSmall(image,radius)
-              : medianFilter_ColorLarge(image,radius);
+    constexpr uint MaxLevel = 0x100;
+
+    const QImage output = image.allGray()
+            ? meanShiftFilter_Impl<uchar>(image,spatialRadius,colorRadius,MaxLevel,tolerance,true)
+            : meanShiftFilter_Impl<QRgb>(image,spatialRadius,colorRadius,MaxLevel,tolerance,true);
+    return output.convertToFormat(image.format());
 }
 
 /*!
     \internal
+
+    Blur the \a count values of \a data that are \a stride apart by [1 2 1]/4 in place,
+    for each of the \a stride values of a cell, with zeros beyond both ends.
+    The \a previous holds the unblurred values of the previous cell.
  */
-static inline qreal colorDistance(QRgb a, QRgb b)
+static inline void blurCells(qreal* data, const int count, const int stride, QVector<qreal>& previous)
 {
-    return ::std::abs(qGray(a)-qGray(b))/qreal(0xff);
+    previous.fill(0,stride);
+    for (int i=0; i<count; ++i)
+    {
+        qreal* cell = data+i*stride;
+        const qreal* next = i+1<count ? cell+stride : nullptr;
+        for (int v=0; v<stride; ++v)
+        {
+            const qreal current = cell[v];
+            cell[v] = (previous[v]+2*current+(next ? next[v] : 0))/4;
+            previous[v] = current;
+        }
+    }
 }
 
 /*!
     \internal
+
+    The bilateral grid of \a image, i.e. the channel sums and the number of pixels in cells of
+    \a spacing x \a spacing pixels and \a depth gray levels, blurred and sliced back by trilinear interpolation.
+
+    The grid is built by strips of rows, each splatted and blurred along x and gray once,
+    in parallel over the grid rows, and then blurred along y while slicing, in parallel over the pixel rows.
+    A strip is kept within StripBytes, so the memory does not grow with the image even if the cells are as small as a pixel.
  */
-static QImage meanShiftFilter_Impl(const QImage& image, uint spatialRadius, qreal colorRadius, uint level, uint maxlevel)
+template<typename Pixel>
+static QImage bilateralGridFilter_Impl(const QImage& image, const int spacing, const qreal depth)
 {
-    Q_ASSUME(image.format()==QImage::Format_RGB32);
+    using Traits = PixelTraits<Pixel>;
 
-    QImage output(image.size(),QImage::Format_RGB32);
+    Q_ASSUME(image.format()==Traits::format());
+
+    QImage output(image.size(),Traits::format());
 
     const int width = image.width();
     const int height = image.height();
-    const int r = spatialRadius;
+    const uchar* const inputBits = image.constBits();
+    const int inputStride = image.bytesPerLine();
 
+    // the grid only has to span the gray levels present in the image
+    int minGray = 0xff;
+    int maxGray = 0;
     for (int y=0; y<height; ++y)
     {
-        QRgb* line = reinterpret_cast<QRgb*>(output.scanLine(y));
-        const QRgb* iLineCenter = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+        const Pixel* iLine = reinterpret_cast<const Pixel*>(inputBits+y*inputStride);
         for (int x=0; x<width; ++x)
         {
-            int rr=0, gg=0, bb=0;
-            int sum=0;
-            for (int i=-r; i<=r; ++i)
+            minGray = qMin<int>(minGray,grayLevel(iLine[x]));
+            maxGray = qMax<int>(maxGray,grayLevel(iLine[x]));
+        }
+    }
+
+    // the channel sums and the weight of a cell
+    constexpr int Values = Traits::Channels+1;
+    // with an empty cell of padding on both ends of each axis, for the blur and the interpolation
+    const int cellsX = (2*(width-1)+spacing)/(2*spacing)+3;
+    const int cellsY = (2*(height-1)+spacing)/(2*spacing)+1;
+    const int cellsZ = qRound((maxGray-minGray)/depth)+3;
+    const int rowSize = cellsX*cellsZ*Values;
+
+    // accumulate the pixels nearest to the grid row j, and blur along x and gray
+    const auto splat = [&](int j, qreal* row, QVector<qreal>& buffer) {
+        ::std::fill_n(row,rowSize,qreal(0));
+        if (j<0 || j>=cellsY)
+            return;
+        for (int y=qMax(0,(j-1)*spacing); y<=(j+1)*spacing && y<height; ++y)
+        {
+            if ((2*y+spacing)/(2*spacing) != j)
+                continue;
+            const Pixel* iLine = reinterpret_cast<const Pixel*>(inputBits+y*inputStride);
+            for (int x=0; x<width; ++x)
             {
-                const int yy = y+i;
-                if (yy<0 || yy>=height)
-                    continue;
-                const QRgb* iLine = reinterpret_cast<const QRgb*>(image.constScanLine(yy));
-                for (int j=-r; j<=r; ++j)
+                const int i = (2*x+spacing)/(2*spacing)+1;
+                const int k = qRound((grayLevel(iLine[x])-minGray)/depth)+1;
+                qreal* cell = row+(cellsZ*i+k)*Values;
+                for (int c=0; c<Traits::Channels; ++c)
                 {
-                    MAYBE_INTERRUPT();
-
-                    const int xx = x+j;
-                    if (xx<0 || xx>=width)
-                        continue;
-                    if (colorDistance(iLineCenter[x],iLine[xx]) > colorRadius)
-                        continue;
-                    rr += qRed(iLine[xx]);
-                    gg += qGreen(iLine[xx]);
-                    bb += qBlue(iLine[xx]);
-                    ++sum;
+                    cell[c] += Traits::channel(iLine[x],c);
                 }
+                cell[Traits::Channels] += 1;
             }
-            line[x] = qRgb(rr/sum,gg/sum,bb/sum);
         }
+        blurCells(row,cellsX,cellsZ*Values,buffer);
+        for (int i=0; i<cellsX; ++i)
+        {
+            blurCells(row+cellsZ*Values*i,cellsZ,Values,buffer);
+        }
+    };
+
+    // the pixel rows of the grid rows [jBegin, jEnd) are interpolated from the grid rows [jBegin, jEnd],
+    // which are blurred along y from the grid rows [jBegin-1, jEnd+1]
+    constexpr int StripBytes = 0x2000000; // 32 MiB
+    const int lastRow = (height-1)/spacing+1;
+    const int stripRows = qBound(1,StripBytes/int(rowSize*sizeof(qreal))-3,lastRow);
+    const int strips = (lastRow+stripRows-1)/stripRows;
+    QVector<qreal> grid;
+    uchar* const outputBits = output.bits();
+    const int outputStride = output.bytesPerLine();
+    for (int strip=0; strip<strips; ++strip)
+    {
+        const int jBegin = strip*stripRows;
+        const int jEnd = qMin(lastRow,jBegin+stripRows);
+        const int gridRows = jEnd-jBegin+3;
+        grid.resize(gridRows*rowSize);
+        qreal* const gridData = grid.data();
+        parallelForRows(gridRows,rowSize*sizeof(qreal),[&](int begin, int end){
+            QVector<qreal> buffer;
+            for (int r=begin; r<end; ++r)
+            {
+                splat(jBegin-1+r,gridData+r*rowSize,buffer);
+            }
+        },qreal(2*strip)/(2*strips),qreal(2*strip+1)/(2*strips));
+        MAYBE_INTERRUPT();
 
-        PROGRESS_UPDATE((level+1.*y/height)/maxlevel);
+        // blur along y
+        const auto blurRow = [&](int j, QVector<qreal>& blurred) {
+            const qreal* rows = gridData+(j-jBegin)*rowSize;
+            blurred.resize(rowSize);
+            for (int v=0; v<rowSize; ++v)
+            {
+                blurred[v] = (rows[v]+2*rows[rowSize+v]+rows[2*rowSize+v])/4;
+            }
+        };
+
+        const int yBegin = jBegin*spacing;
+        const int yEnd = qMin(height,jEnd*spacing);
+        parallelForRows(yEnd-yBegin,inputStride,[&](int begin, int end){
+            QVector<qreal> lower, upper;
+            int j = -1;
+            for (int y=yBegin+begin; y<yBegin+end; ++y)
+            {
+                if (y/spacing != j)
+                {
+                    if (j >= 0 && y/spacing == j+1)
+                    {
+                        lower.swap(upper);
+                    }
+                    else
+                    {
+                        blurRow(y/spacing,lower);
+                    }
+                    j = y/spacing;
+                    blurRow(j+1,upper);
+                }
+
+                const qreal fy = qreal(y-j*spacing)/spacing;
+                const Pixel* iLine = reinterpret_cast<const Pixel*>(inputBits+y*inputStride);
+                Pixel* line = reinterpret_cast<Pixel*>(outputBits+y*outputStride);
+                for (int x=0; x<width; ++x)
+                {
+                    const int i = x/spacing;
+                    const qreal fx = qreal(x-i*spacing)/spacing;
+                    const qreal z = (grayLevel(iLine[x])-minGray)/depth;
+                    const int k = static_cast<int>(z);
+                    const qreal fz = z-k;
+
+                    qreal values[Values] = {};
+                    for (int corner=0; corner<8; ++corner)
+                    {
+                        const int di = corner&1;
+                        const int dk = (corner>>1)&1;
+                        const int dj = corner>>2;
+                        const qreal weight = (di ? fx : 1-fx)*(dk ? fz : 1-fz)*(dj ? fy : 1-fy);
+                        const qreal* cell = (dj ? upper : lower).constData()
+                                + (cellsZ*(i+1+di)+k+1+dk)*Values;
+                        for (int v=0; v<Values; ++v)
+                        {
+                            values[v] += weight*cell[v];
+                        }
+                    }
+
+                    int channels[Traits::Channels];
+                    for (int c=0; c<Traits::Channels; ++c)
+                    {
+                        channels[c] = qBound(0,qRound(values[c]/values[Traits::Channels]),0xff);
+                    }
+                    line[x] = Traits::pixel(channels);
+                }
+            }
+        },qreal(2*strip+1)/(2*strips),qreal(2*strip+2)/(2*strips));
+        MAYBE_INTERRUPT();
     }
 
     return output;
 }
 
 /*!
-    Filter \a image by replacing every value by the mean of the pixels
-    in a range \a spatialRadius neighborhood and whose value is within \a colorRadius.
+    Filter \a image by the bilateral grid, an approximation of the bilateral filter,
+    which smooths the \a image while preserving the edges like meanShiftFilter().
+
+    The pixels are accumulated in a grid of cells \a spatialRadius pixels wide and \a colorRadius deep in gray,
+    which is blurred and then interpolated at every pixel. The cost is linear in the number of pixels
+    plus the number of cells, which is about the number of pixels divided by \a spatialRadius squared,
+    times the range of gray levels in units of \a colorRadius.
+    So it is much lower than meanShiftFilter() from a \a spatialRadius of 2 on,
+    but the cells dominate for a \a spatialRadius of 1 and a small \a colorRadius,
+    where it may be the slower one.
+
+    \quotation
+    Chen, J, Paris, S & Durand, F (2007), "Real-time edge-aware image processing with the bilateral grid",
+    ACM Transactions on Graphics 26(3): 103, doi:10.1145/1276377.1276506
+    \endquotation
  */
-QImage meanShiftFilter(const QImage& image, uint spatialRadius, qreal colorRadius, uint maxLevel)
+QImage bilateralGridFilter(const QImage& image, uint spatialRadius, qreal colorRadius)
 {
-    QImage output = image.convertToFormat(QImage::Format_RGB32);
-    for (uint i=0; i<maxLevel; ++i)
-    {
-        MAYBE_INTERRUPT();
-
-        output = meanShiftFilter_Impl(output,spatialRadius,colorRadius,i,maxLevel);
-    }
+    const int spacing = qMax(1u,spatialRadius);
+    const qreal depth = qMax(colorRadius*0xff,qreal(1));
+    const QImage output = image.allGray()
+            ? bilateralGridFilter_Impl<uchar>(image.convertToFormat(QImage::Format_Grayscale8),spacing,depth)
+            : bilateralGridFilter_Impl<QRgb>(image.convertToFormat(QImage::Format_RGB32),spacing,depth);
     return output.convertToFormat(image.format());
 }
 
@@ -29,9 +29,15 @@
 
 #include <QVector>
 #include <QImage>
+#include <type_traits>
 
 namespace MEMS {
 
+class QuantizedKernel;
+
+template<int Rows, int Columns>
+struct FixedKernel;
+
 class MatrixKernel
 {
 public:
@@ -40,6 +46,8 @@ public:
     MatrixKernel(int rows, int columns, qreal value = 0);
     MatrixKernel(const QVector<QVector<qreal>>& args);
     MatrixKernel(QVector<QVector<qreal>>&& args);
+    template<int Rows, int Columns>
+    MatrixKernel(const FixedKernel<Rows,Columns>& kernel);
 
     int rows() const;
     int columns() const;
@@ -47,6 +55,12 @@ public:
     qreal at(int row, int column) const;
     qreal& operator ()(int row, int column);
     qreal operator ()(int row, int column) const;
+    const qreal* constData() const;
+
+    bool isSeparable() const;
+    bool separate(MatrixKernel* column, MatrixKernel* row) const;
+    MatrixKernel transposed() const;
+    QuantizedKernel quantized(int fractionBits = 16) const;
 
     MatrixKernel& operator =(const MatrixKernel& other);
     MatrixKernel& operator *=(qreal scaler);
@@ -56,14 +70,72 @@ public:
     MatrixKernel operator /(qreal scaler) const;
 
 private:
-    QVector<QVector<qreal>> data;
+    int kerRows = 0;
+    int kerCols = 0;
+    QVector<qreal> data;
 };
 
+inline int MatrixKernel::rows() const
+{
+    return kerRows;
+}
+
+inline int MatrixKernel::columns() const
+{
+    return kerCols;
+}
+
+inline qreal MatrixKernel::at(int row, int column) const
+{
+    return data.at(row*kerCols+column);
+}
+
+inline qreal& MatrixKernel::operator ()(int row, int column)
+{
+    return data[row*kerCols+column];
+}
+
+inline qreal MatrixKernel::operator ()(int row, int column) const
+{
+    return data.at(row*kerCols+column);
+}
+
+inline const qreal* MatrixKernel::constData() const
+{
+    return data.constData();
+}
+
 inline MatrixKernel operator *(qreal scaler, const MatrixKernel& mat)
 {
     return mat*scaler;
 }
 
+template<int Rows, int Columns>
+struct FixedKernel
+{
+    static_assert(Rows>0 && Columns>0 && Rows%2==1 && Columns%2==1,
+                  "The size of kernel must be odd");
+
+    qreal values[Rows][Columns];
+
+    static constexpr int rows() { return Rows; }
+    static constexpr int columns() { return Columns; }
+    constexpr qreal at(int row, int column) const { return values[row][column]; }
+};
+
+template<int Rows, int Columns>
+MatrixKernel::MatrixKernel(const FixedKernel<Rows,Columns>& kernel)
+    : kerRows(Rows), kerCols(Columns), data(Rows*Columns)
+{
+    for (int i=0; i<Rows; ++i)
+    {
+        for (int j=0; j<Columns; ++j)
+        {
+            data[i*Columns+j] = kernel.at(i,j);
+        }
+    }
+}
+
 enum class PaddingType
 {
 //    None = 0,
@@ -72,6 +144,36 @@ enum class PaddingType
     Reflected = 3,
 };
 
+class QuantizedKernel
+{
+public:
+    static constexpr int DefaultFractionBits = 16;
+
+    QuantizedKernel() = default;
+    explicit QuantizedKernel(const MatrixKernel& kernel, int fractionBits = DefaultFractionBits);
+
+    int rows() const;
+    int columns() const;
+    int fractionBits() const;
+    bool isSeparable() const;
+
+    qreal at(int row, int column) const;
+    qreal maxError() const;
+
+private:
+    int kerRows = 0;
+    int kerCols = 0;
+    int bits = 0;
+    QVector<qint32> weights;
+    QVector<qint32> columnWeights;
+    QVector<qint32> rowWeights;
+    int intermediateShift = 0;
+    qreal error = 0;
+
+    friend QImage convolve(const QImage&, const QuantizedKernel&, PaddingType);
+    friend QImage convolve(const QImage&, const QuantizedKernel&, QRgb);
+};
+
 extern QImage convolve(const QImage& image,
                        const MatrixKernel& kernel,
                        PaddingType padding = PaddingType::Fixed);
@@ -82,6 +184,43 @@ extern QImage convolve(const QImage& image,
                        const MatrixKernel& kernel,
                        const QColor& padding);
 
+// the sizes convolve() is instantiated for, other FixedKernel go through MatrixKernel
+template<int Rows, int Columns>
+using EnableFixedConvolve = typename ::std::enable_if<Rows==Columns && (Rows==3 || Rows==5 || Rows==7),int>::type;
+
+template<int Rows, int Columns, EnableFixedConvolve<Rows,Columns> = 0>
+QImage convolve(const QImage& image,
+                const FixedKernel<Rows,Columns>& kernel,
+                PaddingType padding = PaddingType::Fixed);
+template<int Rows, int Columns, EnableFixedConvolve<Rows,Columns> = 0>
+QImage convolve(const QImage& image,
+                const FixedKernel<Rows,Columns>& kernel,
+                QRgb padding);
+template<int Rows, int Columns, EnableFixedConvolve<Rows,Columns> = 0>
+QImage convolve(const QImage& image,
+                const FixedKernel<Rows,Columns>& kernel,
+                const QColor& padding);
+
+extern QImage convolve(const QImage& image,
+                       const QuantizedKernel& kernel,
+                       PaddingType padding = PaddingType::Fixed);
+extern QImage convolve(const QImage& image,
+                       const QuantizedKernel& kernel,
+                       QRgb padding);
+extern QImage convolve(const QImage& image,
+                       const QuantizedKernel& kernel,
+                       const QColor& padding);
+
+extern QImage convolveFFT(const QImage& image,
+                          const MatrixKernel& kernel,
+                          PaddingType padding = PaddingType::Fixed);
+extern QImage convolveFFT(const QImage& image,
+                          const MatrixKernel& kernel,
+                          QRgb padding);
+extern QImage convolveFFT(const QImage& image,
+                          const MatrixKernel& kernel,
+                          const QColor& padding);
+
 extern QImage convolveXY(const QImage& image,
                          const MatrixKernel& kerX,
                          const MatrixKernel& kerY,
@@ -95,6 +234,19 @@ extern QImage convolveXY(const QImage& image,
                          const MatrixKernel& kerY,
                          const QColor& padding);
 
+extern QImage convolveSeparable(const QImage& image,
+                                const MatrixKernel& column,
+                                const MatrixKernel& row,
+                                PaddingType padding = PaddingType::Fixed);
+extern QImage convolveSeparable(const QImage& image,
+                                const MatrixKernel& column,
+                                const MatrixKernel& row,
+                                QRgb padding);
+extern QImage convolveSeparable(const QImage& image,
+                                const MatrixKernel& column,
+                                const MatrixKernel& row,
+                                const QColor& padding);
+
 extern QImage boxFilter(const QImage& image,
                         uint radius = 2,
                         PaddingType padding = PaddingType::Fixed);
@@ -127,12 +279,33 @@ extern QImage gaussianFilter(const QImage& image,
                              qreal sigma,
                              const QColor& padding);
 
+extern QImage recursiveGaussianFilter(const QImage& image,
+                                      qreal sigma);
+extern QImage recursiveGaussianFilter(const QImage& image,
+                                      qreal sigma,
+                                      QRgb padding);
+extern QImage recursiveGaussianFilter(const QImage& image,
+                                      qreal sigma,
+                                      const QColor& padding);
+
 extern QImage medianFilter(const QImage& image, uint radius);
 
+extern QImage guidedFilter(const QImage& image,
+                           uint radius,
+                           qreal epsilon);
+
 extern QImage meanShiftFilter(const QImage& image,
                               uint spatialRadius,
                               qreal colorRadius,
                               uint maxLevel = 1);
+extern QImage meanShiftFilterUntilConverged(const QImage& image,
+                                            uint spatialRadius,
+                                            qreal colorRadius,
+                                            uint tolerance = 1);
+
+extern QImage bilateralGridFilter(const QImage& image,
+                                  uint spatialRadius,
+                                  qreal colorRadius);
 
 } // namespace MEMS
 
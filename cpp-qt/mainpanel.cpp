@@ -54,20 +54,32 @@ MainPanel::MainPanel(QWidget *parent) :
         {tr("Box filter"), Configuration::BoxFilter},
         {tr("Gaussian filter"), Configuration::GaussianFilter},
         {tr("Median filter"), Configuration::MedianFilter},
-        {tr("Mean shift filter"), Configuration::MeanShiftFilter}
+        {tr("Mean shift filter"), Configuration::MeanShiftFilter},
+        {tr("Recursive Gaussian filter"), Configuration::RecursiveGaussianFilter},
+        {tr("Bilateral grid filter"), Configuration::BilateralGridFilter},
+        {tr("Guided filter"), Configuration::GuidedFilter}
     },
     MapThresMethod{
         {tr("Otsu's threshold clustering algorithm"), Configuration::Cluster},
+        {tr("Multi-level Otsu's thresholding"), Configuration::MultiCluster},
         {tr("Mean of gray levels"), Configuration::Mean},
         {tr("Moment-preserving thresholding method"), Configuration::Moments},
         {tr("Huang's fuzzy thresholding method"), Configuration::Fuzziness},
-        {tr("P-tile thresholding"), Configuration::PTile}
+        {tr("P-tile thresholding"), Configuration::PTile},
+        {tr("Kapur's entropy thresholding method"), Configuration::Entropy},
+        {tr("Kittler-Illingworth minimum error thresholding"), Configuration::MinimumError},
+        {tr("Triangle thresholding algorithm"), Configuration::Triangle},
+        {tr("Niblack's local thresholding"), Configuration::Niblack},
+        {tr("Sauvola's local thresholding"), Configuration::Sauvola},
+        {tr("Bradley's local thresholding"), Configuration::Bradley}
     },
     MapEdgeMethod{
         {tr("Sobel operator"), Configuration::Sobel},
         {tr("Prewitt operator"), Configuration::Prewitt},
         {tr("Scharr operator"), Configuration::Scharr},
-        {tr("Laplacian operator"), Configuration::Laplacian}
+        {tr("Laplacian operator"), Configuration::Laplacian},
+        {tr("Morphological boundary"), Configuration::Boundary},
+        {tr("Canny edge detector"), Configuration::Canny}
     },
     MapFitMethod{
         {tr("Naive fit"), Configuration::NaiveFit},
@@ -98,14 +110,64 @@ MainPanel::MainPanel(QWidget *parent) :
             ui->spinBoxFRMS,&QSpinBox::setValue);
     connect(ui->spinBoxFRMS,qOverload<int>(&QSpinBox::valueChanged),
             ui->spinBoxFR,&QSpinBox::setValue);
+    connect(ui->spinBoxFR,qOverload<int>(&QSpinBox::valueChanged),
+            ui->spinBoxFRBG,&QSpinBox::setValue);
+    connect(ui->spinBoxFRBG,qOverload<int>(&QSpinBox::valueChanged),
+            ui->spinBoxFR,&QSpinBox::setValue);
+    connect(ui->spinBoxFR,qOverload<int>(&QSpinBox::valueChanged),
+            ui->spinBoxFRGF,&QSpinBox::setValue);
+    connect(ui->spinBoxFRGF,qOverload<int>(&QSpinBox::valueChanged),
+            ui->spinBoxFR,&QSpinBox::setValue);
     connect(ui->spinBoxFR,qOverload<int>(&QSpinBox::valueChanged),
             this,&MainPanel::changeFilterRadiusRequest);
+    connect(ui->horizontalSliderGS,&QSlider::valueChanged,
+            ui->horizontalSliderGSRG,&QSlider::setValue);
+    connect(ui->horizontalSliderGSRG,&QSlider::valueChanged,
+            ui->horizontalSliderGS,&QSlider::setValue);
+    connect(ui->doubleSpinBoxGS,qOverload<double>(&QDoubleSpinBox::valueChanged),
+            ui->doubleSpinBoxGSRG,&QDoubleSpinBox::setValue);
+    connect(ui->doubleSpinBoxGSRG,qOverload<double>(&QDoubleSpinBox::valueChanged),
+            ui->doubleSpinBoxGS,&QDoubleSpinBox::setValue);
     connect(ui->doubleSpinBoxGS,qOverload<double>(&QDoubleSpinBox::valueChanged),
             this,&MainPanel::changeGaussianSigmaRequest);
+    connect(ui->doubleSpinBoxRGC,qOverload<double>(&QDoubleSpinBox::valueChanged),
+            this,&MainPanel::changeRecursiveGaussianCutoffRequest);
+    connect(ui->horizontalSliderCRMS,&QSlider::valueChanged,
+            ui->horizontalSliderCRBG,&QSlider::setValue);
+    connect(ui->horizontalSliderCRBG,&QSlider::valueChanged,
+            ui->horizontalSliderCRMS,&QSlider::setValue);
+    connect(ui->doubleSpinBoxCRMS,qOverload<double>(&QDoubleSpinBox::valueChanged),
+            ui->doubleSpinBoxCRBG,&QDoubleSpinBox::setValue);
+    connect(ui->doubleSpinBoxCRBG,qOverload<double>(&QDoubleSpinBox::valueChanged),
+            ui->doubleSpinBoxCRMS,&QDoubleSpinBox::setValue);
     connect(ui->doubleSpinBoxCRMS,qOverload<double>(&QDoubleSpinBox::valueChanged),
             this,&MainPanel::changeColorRadiusRequest);
     connect(ui->spinBoxMLMS,qOverload<int>(&QSpinBox::valueChanged),
             this,&MainPanel::changeMaxLevelRequest);
+    connect(ui->checkBoxMSUC,&QCheckBox::toggled,
+            this,&MainPanel::changeMeanShiftUntilConvergedRequest);
+    connect(ui->doubleSpinBoxEPGF,qOverload<double>(&QDoubleSpinBox::valueChanged),
+            this,&MainPanel::changeGuidedFilterEpsilonRequest);
+    connect(ui->spinBoxRLT,qOverload<int>(&QSpinBox::valueChanged),
+            this,&MainPanel::changeLocalThresholdRadiusRequest);
+    connect(ui->doubleSpinBoxWLT,qOverload<double>(&QDoubleSpinBox::valueChanged),
+            this,&MainPanel::changeLocalThresholdWeightRequest);
+    connect(ui->spinBoxCTMC,qOverload<int>(&QSpinBox::valueChanged),
+            ui->spinBoxFCMC,&QSpinBox::setMaximum);
+    connect(ui->spinBoxCTMC,qOverload<int>(&QSpinBox::valueChanged),
+            this,&MainPanel::changeClusterThresholdCountRequest);
+    connect(ui->spinBoxFCMC,qOverload<int>(&QSpinBox::valueChanged),
+            this,&MainPanel::changeForegroundClassRequest);
+    ui->doubleSpinBoxLTCN->setMaximum(ui->doubleSpinBoxHTCN->value());
+    ui->doubleSpinBoxHTCN->setMinimum(ui->doubleSpinBoxLTCN->value());
+    connect(ui->doubleSpinBoxLTCN,qOverload<double>(&QDoubleSpinBox::valueChanged),
+            ui->doubleSpinBoxHTCN,&QDoubleSpinBox::setMinimum);
+    connect(ui->doubleSpinBoxHTCN,qOverload<double>(&QDoubleSpinBox::valueChanged),
+            ui->doubleSpinBoxLTCN,&QDoubleSpinBox::setMaximum);
+    connect(ui->doubleSpinBoxLTCN,qOverload<double>(&QDoubleSpinBox::valueChanged),
+            this,&MainPanel::changeCannyLowThresholdRequest);
+    connect(ui->doubleSpinBoxHTCN,qOverload<double>(&QDoubleSpinBox::valueChanged),
+            this,&MainPanel::changeCannyHighThresholdRequest);
 
     // init progress
     progressUpdater = new ProgressUpdater;
@@ -173,12 +235,30 @@ MainPanel::MainPanel(QWidget *parent) :
             processor,&Processor::setFilterRadius);
     connect(this,&MainPanel::changeGaussianSigmaRequest,
             processor,&Processor::setGaussianSigma);
+    connect(this,&MainPanel::changeRecursiveGaussianCutoffRequest,
+            processor,&Processor::setRecursiveGaussianCutoff);
     connect(this,&MainPanel::changeColorRadiusRequest,
             processor,&Processor::setColorRadius);
     connect(this,&MainPanel::changeMaxLevelRequest,
             processor,&Processor::setMaxLevel);
+    connect(this,&MainPanel::changeMeanShiftUntilConvergedRequest,
+            processor,&Processor::setMeanShiftUntilConverged);
+    connect(this,&MainPanel::changeGuidedFilterEpsilonRequest,
+            processor,&Processor::setGuidedFilterEpsilon);
     connect(this,&MainPanel::changePTileValueRequest,
             processor,&Processor::setPTileValue);
+    connect(this,&MainPanel::changeLocalThresholdRadiusRequest,
+            processor,&Processor::setLocalThresholdRadius);
+    connect(this,&MainPanel::changeLocalThresholdWeightRequest,
+            processor,&Processor::setLocalThresholdWeight);
+    connect(this,&MainPanel::changeClusterThresholdCountRequest,
+            processor,&Processor::setClusterThresholdCount);
+    connect(this,&MainPanel::changeForegroundClassRequest,
+            processor,&Processor::setForegroundClass);
+    connect(this,&MainPanel::changeCannyLowThresholdRequest,
+            processor,&Processor::setCannyLowThreshold);
+    connect(this,&MainPanel::changeCannyHighThresholdRequest,
+            processor,&Processor::setCannyHighThreshold);
     connect(this,&MainPanel::saveConfigurationsRequest,
             processor,&Processor::saveConfigurations);
 
@@ -220,9 +300,27 @@ void MainPanel::setByConfig(const Configuration& config)
     ui->comboBoxCorr->setCurrentText(MapErrCorrMethod.key(config.errorCorrectionMethod()));
     ui->spinBoxFR->setValue(config.filterRadius());
     ui->doubleSpinBoxGS->setValue(config.gaussianSigma());
+    ui->doubleSpinBoxRGC->setValue(config.recursiveGaussianCutoff());
     ui->doubleSpinBoxCRMS->setValue(config.colorRadius());
     ui->spinBoxMLMS->setValue(config.maxLevel());
+    ui->checkBoxMSUC->setChecked(config.meanShiftUntilConverged());
+    ui->doubleSpinBoxEPGF->setValue(config.guidedFilterEpsilon());
     ui->spinBoxPT->setValue(::std::round(100*config.pTileValue()));
+    ui->spinBoxRLT->setValue(config.localThresholdRadius());
+    ui->doubleSpinBoxWLT->setValue(config.localThresholdWeight());
+    ui->spinBoxCTMC->setValue(config.clusterThresholdCount());
+    ui->spinBoxFCMC->setValue(config.foregroundClass());
+    // move the bound on the side the thresholds go first, so that they stay ordered
+    if (config.cannyLowThreshold() > ui->doubleSpinBoxHTCN->value())
+    {
+        ui->doubleSpinBoxHTCN->setValue(config.cannyHighThreshold());
+        ui->doubleSpinBoxLTCN->setValue(config.cannyLowThreshold());
+    }
+    else
+    {
+        ui->doubleSpinBoxLTCN->setValue(config.cannyLowThreshold());
+        ui->doubleSpinBoxHTCN->setValue(config.cannyHighThreshold());
+    }
 }
 
 void MainPanel::setOrigin(const QString& key)
@@ -350,6 +448,14 @@ void MainPanel::on_doubleSpinBoxCRMS_valueChanged(double arg1)
     ui->horizontalSliderCRMS->setValue(static_cast<int>(100*arg1));
 }
 
+void MainPanel::on_checkBoxMSUC_toggled(bool checked)
+{
+    // the iterations stop only at convergence, whatever the max level
+    ui->labelMLMS->setDisabled(checked);
+    ui->horizontalSliderMLMS->setDisabled(checked);
+    ui->spinBoxMLMS->setDisabled(checked);
+}
+
 void MainPanel::on_radioButtonA_toggled(bool checked)
 {
     if (checked)
@@ -383,9 +489,18 @@ void MainPanel::on_comboBoxFilter_currentIndexChanged(const QString& arg1)
     case Configuration::GaussianFilter:
         ui->stackedWidgetFilter->setCurrentWidget(ui->pageFilterG);
         break;
+    case Configuration::RecursiveGaussianFilter:
+        ui->stackedWidgetFilter->setCurrentWidget(ui->pageFilterRG);
+        break;
     case Configuration::MeanShiftFilter:
         ui->stackedWidgetFilter->setCurrentWidget(ui->pageFilterMS);
         break;
+    case Configuration::BilateralGridFilter:
+        ui->stackedWidgetFilter->setCurrentWidget(ui->pageFilterBG);
+        break;
+    case Configuration::GuidedFilter:
+        ui->stackedWidgetFilter->setCurrentWidget(ui->pageFilterGF);
+        break;
     default:
         ui->stackedWidgetFilter->setCurrentWidget(ui->pageFilter);
         break;
@@ -401,6 +516,14 @@ void MainPanel::on_comboBoxThres_currentIndexChanged(const QString& arg1)
     case Configuration::PTile:
         ui->stackedWidgetThres->setCurrentWidget(ui->pageThresPT);
         break;
+    case Configuration::Niblack:
+    case Configuration::Sauvola:
+    case Configuration::Bradley:
+        ui->stackedWidgetThres->setCurrentWidget(ui->pageThresLT);
+        break;
+    case Configuration::MultiCluster:
+        ui->stackedWidgetThres->setCurrentWidget(ui->pageThresMC);
+        break;
     default:
         ui->stackedWidgetThres->setCurrentWidget(ui->pageThres);
         break;
@@ -409,7 +532,17 @@ void MainPanel::on_comboBoxThres_currentIndexChanged(const QString& arg1)
 
 void MainPanel::on_comboBoxEdge_currentIndexChanged(const QString& arg1)
 {
-    emit changeEdgeDetectionMethodRequest(MapEdgeMethod.value(arg1,Configuration::defaultEdgeDetectionMethod()));
+    auto method = MapEdgeMethod.value(arg1,Configuration::defaultEdgeDetectionMethod());
+    emit changeEdgeDetectionMethodRequest(method);
+    switch (method)
+    {
+    case Configuration::Canny:
+        ui->stackedWidgetEdge->setCurrentWidget(ui->pageEdgeCanny);
+        break;
+    default:
+        ui->stackedWidgetEdge->setCurrentWidget(ui->pageEdge);
+        break;
+    }
 }
 
 void MainPanel::on_comboBoxFit_currentIndexChanged(const QString& arg1)
@@ -60,9 +60,18 @@ signals:
     void changeErrorCorrectionMethodRequest(Configuration::ErrorCorrectionMethod method);
     void changeFilterRadiusRequest(uint radius);
     void changeGaussianSigmaRequest(qreal sigma);
+    void changeRecursiveGaussianCutoffRequest(qreal sigma);
     void changeColorRadiusRequest(qreal radius);
     void changeMaxLevelRequest(uint level);
+    void changeMeanShiftUntilConvergedRequest(bool untilConverged);
+    void changeGuidedFilterEpsilonRequest(qreal epsilon);
     void changePTileValueRequest(qreal value);
+    void changeLocalThresholdRadiusRequest(uint radius);
+    void changeLocalThresholdWeightRequest(qreal weight);
+    void changeClusterThresholdCountRequest(uint count);
+    void changeForegroundClassRequest(uint index);
+    void changeCannyLowThresholdRequest(qreal threshold);
+    void changeCannyHighThresholdRequest(qreal threshold);
     void saveConfigurationsRequest(const QString& group);
 
 private:
@@ -87,6 +96,7 @@ private slots:
     void on_doubleSpinBoxGS_valueChanged(double arg1);
     void on_horizontalSliderCRMS_valueChanged(int value);
     void on_doubleSpinBoxCRMS_valueChanged(double arg1);
+    void on_checkBoxMSUC_toggled(bool checked);
     void on_radioButtonA_toggled(bool checked);
     void on_radioButtonB_toggled(bool checked);
     void on_radioButtonC_toggled(bool checked);
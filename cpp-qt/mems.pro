@@ -12,7 +12,7 @@ CONFIG(release, debug|release) {
     DEFINES += QT_NO_DEBUG_OUTPUT
     DEFINES += NO_TIMING_OUTPUT
 }
-QT += core gui widgets
+QT += core gui widgets concurrent
 
 translationDir = translations
 settingFile = config.ini
@@ -25,6 +25,7 @@ SOURCES += main.cpp \
     thresholding.cpp \
     edgedetect.cpp \
     circlefit.cpp \
+    fft.cpp \
     processor.cpp \
     configuration.cpp \
     progressupdater.cpp \
@@ -38,6 +39,7 @@ HEADERS += \
     thresholding.h \
     edgedetect.h \
     circlefit.h \
+    fft.h \
     processor.h \
     configuration.h \
     algorithms.h \
@@ -15,7 +15,7 @@
     </message>
     <message>
         <location filename="mainpanel.ui" line="91"/>
-        <location filename="mainpanel.cpp" line="236"/>
+        <location filename="mainpanel.cpp" line="334"/>
         <source>A</source>
         <translation>A</translation>
     </message>
@@ -26,7 +26,7 @@
     </message>
     <message>
         <location filename="mainpanel.ui" line="108"/>
-        <location filename="mainpanel.cpp" line="241"/>
+        <location filename="mainpanel.cpp" line="339"/>
         <source>B</source>
         <translation>B</translation>
     </message>
@@ -37,7 +37,7 @@
     </message>
     <message>
         <location filename="mainpanel.ui" line="125"/>
-        <location filename="mainpanel.cpp" line="247"/>
+        <location filename="mainpanel.cpp" line="345"/>
         <source>C</source>
         <translation>C</translation>
     </message>
@@ -59,97 +59,151 @@
     <message>
         <location filename="mainpanel.ui" line="187"/>
         <location filename="mainpanel.ui" line="249"/>
+        <location filename="mainpanel.ui" line="729"/>
         <source>Filter radius:</source>
         <oldsource>Filter radius: </oldsource>
         <translation>滤波半径：</translation>
     </message>
     <message>
         <location filename="mainpanel.ui" line="292"/>
+        <location filename="mainpanel.ui" line="550"/>
         <source>Gaussian sigma:</source>
         <translation>高斯标准差：</translation>
     </message>
     <message>
-        <location filename="mainpanel.ui" line="360"/>
+        <location filename="mainpanel.ui" line="344"/>
+        <source>Recursive from sigma:</source>
+        <translation>递归滤波起始标准差：</translation>
+    </message>
+    <message>
+        <location filename="mainpanel.ui" line="351"/>
+        <source>Off</source>
+        <translation>关闭</translation>
+    </message>
+    <message>
+        <location filename="mainpanel.ui" line="389"/>
+        <location filename="mainpanel.ui" line="618"/>
         <source>Spatial radius:</source>
         <translation>空间滤波半径：</translation>
     </message>
     <message>
-        <location filename="mainpanel.ui" line="403"/>
+        <location filename="mainpanel.ui" line="432"/>
+        <location filename="mainpanel.ui" line="661"/>
         <source>Color radius:</source>
         <translation>色彩滤波半径：</translation>
     </message>
     <message>
-        <location filename="mainpanel.ui" line="455"/>
+        <location filename="mainpanel.ui" line="484"/>
         <source>Max level:</source>
         <translation>最大等级：</translation>
     </message>
     <message>
-        <location filename="mainpanel.ui" line="504"/>
+        <location filename="mainpanel.ui" line="527"/>
+        <source>Iterate until converged</source>
+        <translation>迭代至收敛</translation>
+    </message>
+    <message>
+        <location filename="mainpanel.ui" line="772"/>
+        <source>Regularization:</source>
+        <translation>正则化参数：</translation>
+    </message>
+    <message>
+        <location filename="mainpanel.ui" line="804"/>
         <source>Step 2: Binarize</source>
         <translation>第二步：二值化</translation>
     </message>
     <message>
-        <location filename="mainpanel.ui" line="515"/>
+        <location filename="mainpanel.ui" line="815"/>
         <source>Select thresholding method:</source>
         <translation>选择阈值分割方法：</translation>
     </message>
     <message>
-        <location filename="mainpanel.ui" line="547"/>
+        <location filename="mainpanel.ui" line="847"/>
         <source>Black fraction:</source>
         <translation>背景比例：</translation>
     </message>
     <message>
-        <location filename="mainpanel.ui" line="593"/>
+        <location filename="mainpanel.ui" line="903"/>
+        <source>Window radius:</source>
+        <translation>窗口半径：</translation>
+    </message>
+    <message>
+        <location filename="mainpanel.ui" line="946"/>
+        <source>Weight:</source>
+        <translation>权重：</translation>
+    </message>
+    <message>
+        <location filename="mainpanel.ui" line="988"/>
+        <source>Thresholds:</source>
+        <translation>阈值个数：</translation>
+    </message>
+    <message>
+        <location filename="mainpanel.ui" line="1008"/>
+        <source>Foreground class:</source>
+        <translation>前景类别：</translation>
+    </message>
+    <message>
+        <location filename="mainpanel.ui" line="1031"/>
         <source>Step 3: Edge detection</source>
         <translation>第三步：边缘检测</translation>
     </message>
     <message>
-        <location filename="mainpanel.ui" line="602"/>
+        <location filename="mainpanel.ui" line="1042"/>
         <source>Select edge detection method:</source>
         <translation>选择边缘检测方法：</translation>
     </message>
     <message>
-        <location filename="mainpanel.ui" line="614"/>
+        <location filename="mainpanel.ui" line="1071"/>
+        <source>Low threshold:</source>
+        <translation>低阈值：</translation>
+    </message>
+    <message>
+        <location filename="mainpanel.ui" line="1091"/>
+        <source>High threshold:</source>
+        <translation>高阈值：</translation>
+    </message>
+    <message>
+        <location filename="mainpanel.ui" line="1117"/>
         <source>Step 4: Circle fit</source>
         <translation>第四步：圆拟合</translation>
     </message>
     <message>
-        <location filename="mainpanel.ui" line="625"/>
+        <location filename="mainpanel.ui" line="1128"/>
         <source>Select fit method:</source>
         <translation>选择拟合方法：</translation>
     </message>
     <message>
-        <location filename="mainpanel.ui" line="639"/>
+        <location filename="mainpanel.ui" line="1142"/>
         <source>Select error correction method:</source>
         <translation>选择误差校正方法：</translation>
     </message>
     <message>
-        <location filename="mainpanel.ui" line="699"/>
+        <location filename="mainpanel.ui" line="1202"/>
         <source>Filtered Image</source>
         <translation>滤波图像</translation>
     </message>
     <message>
-        <location filename="mainpanel.ui" line="716"/>
+        <location filename="mainpanel.ui" line="1219"/>
         <source>Binarized Image</source>
         <translation>二值化图像</translation>
     </message>
     <message>
-        <location filename="mainpanel.ui" line="733"/>
+        <location filename="mainpanel.ui" line="1236"/>
         <source>Edge Image</source>
         <translation>边缘图像</translation>
     </message>
     <message>
-        <location filename="mainpanel.ui" line="750"/>
+        <location filename="mainpanel.ui" line="1253"/>
         <source>Circle Image</source>
         <translation>拟合圆图像</translation>
     </message>
     <message>
-        <location filename="mainpanel.ui" line="785"/>
+        <location filename="mainpanel.ui" line="1288"/>
         <source>Save Configuration</source>
         <translation>保存配置</translation>
     </message>
     <message>
-        <location filename="mainpanel.ui" line="792"/>
+        <location filename="mainpanel.ui" line="1295"/>
         <source>Load Configuration</source>
         <translation>加载配置</translation>
     </message>
@@ -173,83 +227,143 @@
         <source>Mean shift filter</source>
         <translation>均值平移滤波器</translation>
     </message>
+    <message>
+        <location filename="mainpanel.cpp" line="58"/>
+        <source>Recursive Gaussian filter</source>
+        <translation>递归高斯滤波器</translation>
+    </message>
+    <message>
+        <location filename="mainpanel.cpp" line="59"/>
+        <source>Bilateral grid filter</source>
+        <translation>双边网格滤波器</translation>
+    </message>
     <message>
         <location filename="mainpanel.cpp" line="60"/>
+        <source>Guided filter</source>
+        <translation>导向滤波器</translation>
+    </message>
+    <message>
+        <location filename="mainpanel.cpp" line="63"/>
         <source>Otsu&apos;s threshold clustering algorithm</source>
         <translation>大津法</translation>
     </message>
     <message>
-        <location filename="mainpanel.cpp" line="61"/>
+        <location filename="mainpanel.cpp" line="64"/>
+        <source>Multi-level Otsu&apos;s thresholding</source>
+        <translation>多阈值大津法</translation>
+    </message>
+    <message>
+        <location filename="mainpanel.cpp" line="65"/>
         <source>Mean of gray levels</source>
         <translation>灰度平均值</translation>
     </message>
     <message>
-        <location filename="mainpanel.cpp" line="62"/>
+        <location filename="mainpanel.cpp" line="66"/>
         <source>Moment-preserving thresholding method</source>
         <translation>力矩保持法</translation>
     </message>
     <message>
-        <location filename="mainpanel.cpp" line="63"/>
+        <location filename="mainpanel.cpp" line="67"/>
         <source>Huang&apos;s fuzzy thresholding method</source>
         <translation>模糊度阈值分割方法</translation>
     </message>
     <message>
-        <location filename="mainpanel.cpp" line="64"/>
+        <location filename="mainpanel.cpp" line="68"/>
         <source>P-tile thresholding</source>
         <translation>P-Tile比例阈值分割</translation>
     </message>
     <message>
-        <location filename="mainpanel.cpp" line="67"/>
+        <location filename="mainpanel.cpp" line="69"/>
+        <source>Kapur&apos;s entropy thresholding method</source>
+        <translation>Kapur熵阈值分割方法</translation>
+    </message>
+    <message>
+        <location filename="mainpanel.cpp" line="70"/>
+        <source>Kittler-Illingworth minimum error thresholding</source>
+        <translation>Kittler-Illingworth最小误差阈值分割</translation>
+    </message>
+    <message>
+        <location filename="mainpanel.cpp" line="71"/>
+        <source>Triangle thresholding algorithm</source>
+        <translation>三角形阈值分割算法</translation>
+    </message>
+    <message>
+        <location filename="mainpanel.cpp" line="72"/>
+        <source>Niblack&apos;s local thresholding</source>
+        <translation>Niblack局部阈值分割</translation>
+    </message>
+    <message>
+        <location filename="mainpanel.cpp" line="73"/>
+        <source>Sauvola&apos;s local thresholding</source>
+        <translation>Sauvola局部阈值分割</translation>
+    </message>
+    <message>
+        <location filename="mainpanel.cpp" line="74"/>
+        <source>Bradley&apos;s local thresholding</source>
+        <translation>Bradley局部阈值分割</translation>
+    </message>
+    <message>
+        <location filename="mainpanel.cpp" line="77"/>
         <source>Sobel operator</source>
         <translation>Sobel算子</translation>
     </message>
     <message>
-        <location filename="mainpanel.cpp" line="68"/>
+        <location filename="mainpanel.cpp" line="78"/>
         <source>Prewitt operator</source>
         <translation>Prewitt算子</translation>
     </message>
     <message>
-        <location filename="mainpanel.cpp" line="69"/>
+        <location filename="mainpanel.cpp" line="79"/>
         <source>Scharr operator</source>
         <translation>Scharr算子</translation>
     </message>
     <message>
-        <location filename="mainpanel.cpp" line="70"/>
+        <location filename="mainpanel.cpp" line="80"/>
         <source>Laplacian operator</source>
         <translation>拉普拉斯算子</translation>
     </message>
     <message>
-        <location filename="mainpanel.cpp" line="73"/>
+        <location filename="mainpanel.cpp" line="81"/>
+        <source>Morphological boundary</source>
+        <translation>形态学边界</translation>
+    </message>
+    <message>
+        <location filename="mainpanel.cpp" line="82"/>
+        <source>Canny edge detector</source>
+        <translation>Canny边缘检测</translation>
+    </message>
+    <message>
+        <location filename="mainpanel.cpp" line="85"/>
         <source>Naive fit</source>
         <translation>幼稚的拟合法</translation>
     </message>
     <message>
-        <location filename="mainpanel.cpp" line="74"/>
+        <location filename="mainpanel.cpp" line="86"/>
         <source>Simple algebraic fit</source>
         <translation>简单的代数拟合法</translation>
     </message>
     <message>
-        <location filename="mainpanel.cpp" line="75"/>
+        <location filename="mainpanel.cpp" line="87"/>
         <source>Hyper algebraic fit</source>
         <translation>超级代数拟合法</translation>
     </message>
     <message>
-        <location filename="mainpanel.cpp" line="78"/>
+        <location filename="mainpanel.cpp" line="90"/>
         <source>No correction</source>
         <translation>无校正</translation>
     </message>
     <message>
-        <location filename="mainpanel.cpp" line="79"/>
+        <location filename="mainpanel.cpp" line="91"/>
         <source>Median error correction</source>
         <translation>中位误差校正</translation>
     </message>
     <message>
-        <location filename="mainpanel.cpp" line="80"/>
+        <location filename="mainpanel.cpp" line="92"/>
         <source>Connectivity-based correction</source>
         <translation>基于连通性的误差校正</translation>
     </message>
     <message>
-        <location filename="mainpanel.cpp" line="255"/>
+        <location filename="mainpanel.cpp" line="353"/>
         <source>The center of the circle is (%1, %2), and the radius is %3</source>
         <translation>圆心为(%1, %2)，半径为%3</translation>
     </message>
@@ -257,27 +371,28 @@
 <context>
     <name>Processor</name>
     <message>
-        <location filename="processor.cpp" line="93"/>
+        <location filename="processor.cpp" line="115"/>
         <source>filtering...</source>
         <translation>滤波中...</translation>
     </message>
     <message>
-        <location filename="processor.cpp" line="124"/>
+        <location filename="processor.cpp" line="169"/>
+        <location filename="processor.cpp" line="224"/>
         <source>thresholding...</source>
         <translation>阈值分割中...</translation>
     </message>
     <message>
-        <location filename="processor.cpp" line="158"/>
+        <location filename="processor.cpp" line="260"/>
         <source>edge-detecting...</source>
         <translation>边缘检测中...</translation>
     </message>
     <message>
-        <location filename="processor.cpp" line="190"/>
+        <location filename="processor.cpp" line="303"/>
         <source>circle fitting...</source>
         <translation>圆拟合中...</translation>
     </message>
     <message>
-        <location filename="processor.cpp" line="232"/>
+        <location filename="processor.cpp" line="345"/>
         <source>Center: (%1, %2)
 Radius: %3</source>
         <translation>圆心：(%1, %2)
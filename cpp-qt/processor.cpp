@@ -30,6 +30,8 @@
 #include <QPointer>
 #include <QVector>
 #include <QPoint>
+#include <QSize>
+#include <QMetaMethod>
 #include <QPainter>
 #include <QPen>
 #include <QFont>
@@ -58,14 +60,25 @@ public:
 
     uint filterRadius;
     qreal gaussianSigma;
+    qreal recursiveGaussianCutoff;
     qreal colorRadius;
     uint maxLevel;
+    bool meanShiftUntilConverged;
+    qreal guidedFilterEpsilon;
 
     qreal pTileValue;
-
-    MEMS::Histogram filteredHisto;
+    uint localThresholdRadius;
+    qreal localThresholdWeight;
+    uint clusterThresholdCount;
+    uint foregroundClass;
+    qreal cannyLowThreshold;
+    qreal cannyHighThreshold;
+
+    MEMS::HistogramStats filteredStats;
+    MEMS::IntegralImage filteredIntegral;
     int threshold;
     QVector<QPoint> edgePixels;
+    QSize edgeSize;
     bool lazy = true;
 
     Impl(Processor* interface, const Configuration& config)
@@ -77,9 +90,18 @@ public:
           errorCorrectionMethod(config.errorCorrectionMethod()),
           filterRadius(config.filterRadius()),
           gaussianSigma(config.gaussianSigma()),
+          recursiveGaussianCutoff(config.recursiveGaussianCutoff()),
           colorRadius(config.colorRadius()),
           maxLevel(config.maxLevel()),
-          pTileValue(config.pTileValue())
+          meanShiftUntilConverged(config.meanShiftUntilConverged()),
+          guidedFilterEpsilon(config.guidedFilterEpsilon()),
+          pTileValue(config.pTileValue()),
+          localThresholdRadius(config.localThresholdRadius()),
+          localThresholdWeight(config.localThresholdWeight()),
+          clusterThresholdCount(config.clusterThresholdCount()),
+          foregroundClass(config.foregroundClass()),
+          cannyLowThreshold(qMin(config.cannyLowThreshold(),config.cannyHighThreshold())),
+          cannyHighThreshold(qMax(config.cannyLowThreshold(),config.cannyHighThreshold()))
     {
     }
 
@@ -98,13 +120,31 @@ public:
             nextImage = TIMING(boxFilter(origin,filterRadius));
             break;
         case Configuration::GaussianFilter:
-            nextImage = TIMING(gaussianFilter(origin,filterRadius,gaussianSigma));
+            // a recursive filter costs the same for any sigma, while the radius has to grow with it;
+            // switch only when the kernel already spans 3 sigma, or the result would change
+            if (recursiveGaussianCutoff > 0 && gaussianSigma >= recursiveGaussianCutoff
+                    && filterRadius >= 3*gaussianSigma)
+                nextImage = TIMING(recursiveGaussianFilter(origin,gaussianSigma));
+            else
+                nextImage = TIMING(gaussianFilter(origin,filterRadius,gaussianSigma));
             break;
         case Configuration::MedianFilter:
             nextImage = TIMING(medianFilter(origin,filterRadius));
             break;
         case Configuration::MeanShiftFilter:
-            nextImage = TIMING(meanShiftFilter(origin,filterRadius,colorRadius,maxLevel));
+            if (meanShiftUntilConverged)
+                nextImage = TIMING(meanShiftFilterUntilConverged(origin,filterRadius,colorRadius));
+            else
+                nextImage = TIMING(meanShiftFilter(origin,filterRadius,colorRadius,maxLevel));
+            break;
+        case Configuration::RecursiveGaussianFilter:
+            nextImage = TIMING(recursiveGaussianFilter(origin,gaussianSigma));
+            break;
+        case Configuration::BilateralGridFilter:
+            nextImage = TIMING(bilateralGridFilter(origin,filterRadius,colorRadius));
+            break;
+        case Configuration::GuidedFilter:
+            nextImage = TIMING(guidedFilter(origin,filterRadius,guidedFilterEpsilon));
             break;
         default:
             Q_UNREACHABLE();
@@ -119,26 +159,40 @@ public:
         using namespace MEMS;
         if (lazy)
             return;
-        if (filtered.isNull() || filteredHisto.isEmpty())
+        if (filtered.isNull() || filteredStats.histogram().isEmpty())
             return;
+        if (!hasGlobalThreshold())
+        {
+            updateBinaryImage();
+            return;
+        }
         ProgressUpdaterContext context(Processor::tr("thresholding..."));
         int nextThres;
         switch (thresholdingMethod)
         {
         case Configuration::Cluster:
-            nextThres = TIMING(clusterThreshold(filteredHisto));
+            nextThres = TIMING(clusterThreshold(filteredStats));
             break;
         case Configuration::Mean:
-            nextThres = TIMING(meanThreshold(filteredHisto));
+            nextThres = TIMING(meanThreshold(filteredStats));
             break;
         case Configuration::Moments:
-            nextThres = TIMING(momentsThreshold(filteredHisto));
+            nextThres = TIMING(momentsThreshold(filteredStats));
             break;
         case Configuration::Fuzziness:
-            nextThres = TIMING(fuzzinessThreshold(filteredHisto));
+            nextThres = TIMING(fuzzinessThreshold(filteredStats));
             break;
         case Configuration::PTile:
-            nextThres = TIMING(pTileThreshold(filteredHisto,pTileValue));
+            nextThres = TIMING(pTileThreshold(filteredStats,pTileValue));
+            break;
+        case Configuration::Entropy:
+            nextThres = TIMING(entropyThreshold(filteredStats));
+            break;
+        case Configuration::MinimumError:
+            nextThres = TIMING(minimumErrorThreshold(filteredStats));
+            break;
+        case Configuration::Triangle:
+            nextThres = TIMING(triangleThreshold(filteredStats));
             break;
         default:
             Q_UNREACHABLE();
@@ -148,15 +202,65 @@ public:
         q->setThreshold(nextThres);
     }
 
+    bool hasGlobalThreshold() const
+    {
+        return thresholdingMethod != Configuration::Niblack
+                && thresholdingMethod != Configuration::Sauvola
+                && thresholdingMethod != Configuration::Bradley
+                && thresholdingMethod != Configuration::MultiCluster;
+    }
+
+    const MEMS::IntegralImage& integralImage()
+    {
+        // the tables are kept for the filtered image, so changing the method or the window is cheap
+        if (filteredIntegral.isNull())
+            filteredIntegral = TIMING(MEMS::IntegralImage(filtered));
+        return filteredIntegral;
+    }
+
+    void updateBinaryImage()
+    {
+        using namespace MEMS;
+        ProgressUpdaterContext context(Processor::tr("thresholding..."));
+        QImage nextImage;
+        switch (thresholdingMethod)
+        {
+        case Configuration::MultiCluster:
+        {
+            const QVector<int> thresholds = TIMING(clusterThresholds(filteredStats,qMax(1u,clusterThresholdCount)));
+            nextImage = binarize(filtered,thresholds,qMin<int>(foregroundClass,thresholds.size()));
+            break;
+        }
+        case Configuration::Niblack:
+            nextImage = TIMING(niblackBinarize(integralImage(),localThresholdRadius,localThresholdWeight));
+            break;
+        case Configuration::Sauvola:
+            nextImage = TIMING(sauvolaBinarize(integralImage(),localThresholdRadius,localThresholdWeight));
+            break;
+        case Configuration::Bradley:
+            nextImage = TIMING(bradleyBinarize(integralImage(),localThresholdRadius,localThresholdWeight));
+            break;
+        default:
+            Q_UNREACHABLE();
+            break;
+        }
+        context.end();
+        // there is no global threshold
+        q->setThreshold(-1);
+        q->setBinaryImage(nextImage);
+    }
+
     void updateEdgeImage()
     {
         using namespace MEMS;
         if (lazy)
             return;
-        if (binarized.isNull())
+        if (edgeMethod == Configuration::Canny ? filtered.isNull() : binarized.isNull())
             return;
         ProgressUpdaterContext context(Processor::tr("edge-detecting..."));
         QImage nextImage;
+        QVector<QPoint> nextPoints;
+        QSize nextSize;
         switch (edgeMethod)
         {
         case Configuration::Sobel:
@@ -171,12 +275,24 @@ public:
         case Configuration::Laplacian:
             nextImage = TIMING(laplacianOperator(binarized));
             break;
+        case Configuration::Boundary:
+            nextPoints = TIMING(boundaryPoints(binarized));
+            nextSize = binarized.size();
+            break;
+        case Configuration::Canny:
+            nextPoints = TIMING(cannyPoints(filtered,cannyLowThreshold,cannyHighThreshold));
+            nextSize = filtered.size();
+            break;
         default:
             Q_UNREACHABLE();
             break;
         }
         context.end();
-        q->setEdgeImage(nextImage);
+        // these detectors give the edge pixels directly
+        if (edgeMethod == Configuration::Boundary || edgeMethod == Configuration::Canny)
+            q->setEdgePixels(nextPoints,nextSize);
+        else
+            q->setEdgeImage(nextImage);
     }
 
     void updateCircle()
@@ -184,7 +300,7 @@ public:
         using namespace MEMS;
         if (lazy)
             return;
-        if (edge.isNull() || edgePixels.isEmpty())
+        if (edgePixels.isEmpty())
             return;
         CircleFitFunction fit = nullptr;
         ProgressUpdaterContext context(Processor::tr("circle fitting..."));
@@ -284,9 +400,14 @@ void Processor::setFilteredImage(const QImage& filtered)
     d->filtered = filtered;
     emit filteredImageChanged(d->filtered);
 
-    d->filteredHisto = MEMS::grayscaleHistogram(d->filtered);
+    d->filteredStats = MEMS::HistogramStats(MEMS::grayscaleHistogram(d->filtered));
+    d->filteredIntegral = MEMS::IntegralImage();
     d->updateThreshold();
-    setBinaryImage(MEMS::binarize(d->filtered,d->threshold));
+    if (d->hasGlobalThreshold())
+        setBinaryImage(MEMS::binarize(d->filtered,d->threshold));
+    // the Canny detector runs on the filtered image rather than the binary one
+    if (d->edgeMethod == Configuration::Canny)
+        d->updateEdgeImage();
 }
 
 QImage Processor::binaryImage() const
@@ -303,11 +424,15 @@ void Processor::setBinaryImage(const QImage& binary)
     d->binarized = binary;
     emit binaryImageChanged(d->binarized);
 
-    d->updateEdgeImage();
+    if (d->edgeMethod != Configuration::Canny)
+        d->updateEdgeImage();
 }
 
 QImage Processor::edgeImage() const
 {
+    // the edge image of the edge pixels is only drawn once asked for
+    if (d->edge.isNull() && d->edgeSize.isValid())
+        d->edge = MEMS::edgePointsImage(d->edgeSize,d->edgePixels);
     return d->edge;
 }
 
@@ -318,12 +443,26 @@ void Processor::setEdgeImage(const QImage& edge)
     if (d->edge == edge)
         return;
     d->edge = edge;
+    d->edgeSize = edge.size();
     emit edgeImageChanged(d->edge);
 
     d->edgePixels = MEMS::whitePixelPositions(d->edge);
     d->updateCircle();
 }
 
+void Processor::setEdgePixels(const QVector<QPoint>& edgePixels, const QSize& size)
+{
+    if (d->edgeSize == size && d->edgePixels == edgePixels)
+        return;
+    d->edgePixels = edgePixels;
+    d->edgeSize = size;
+    d->edge = QImage();
+    if (isSignalConnected(QMetaMethod::fromSignal(&Processor::edgeImageChanged)))
+        emit edgeImageChanged(edgeImage());
+
+    d->updateCircle();
+}
+
 QImage Processor::circleImage() const
 {
     return d->circle;
@@ -374,9 +513,18 @@ Configuration Processor::configurations() const
             .setErrorCorrectionMethod(d->errorCorrectionMethod)
             .setFilterRadius(d->filterRadius)
             .setGaussianSigma(d->gaussianSigma)
+            .setRecursiveGaussianCutoff(d->recursiveGaussianCutoff)
             .setColorRadius(d->colorRadius)
             .setMaxLevel(d->maxLevel)
-            .setPTileValue(d->pTileValue);
+            .setMeanShiftUntilConverged(d->meanShiftUntilConverged)
+            .setGuidedFilterEpsilon(d->guidedFilterEpsilon)
+            .setPTileValue(d->pTileValue)
+            .setLocalThresholdRadius(d->localThresholdRadius)
+            .setLocalThresholdWeight(d->localThresholdWeight)
+            .setClusterThresholdCount(d->clusterThresholdCount)
+            .setForegroundClass(d->foregroundClass)
+            .setCannyLowThreshold(d->cannyLowThreshold)
+            .setCannyHighThreshold(d->cannyHighThreshold);
 }
 
 void Processor::setConfigurations(const Configuration& config)
@@ -385,10 +533,28 @@ void Processor::setConfigurations(const Configuration& config)
     setFilterMethod(config.filterMethod());
     setFilterRadius(config.filterRadius());
     setGaussianSigma(config.gaussianSigma());
+    setRecursiveGaussianCutoff(config.recursiveGaussianCutoff());
     setColorRadius(config.colorRadius());
     setMaxLevel(config.maxLevel());
+    setMeanShiftUntilConverged(config.meanShiftUntilConverged());
+    setGuidedFilterEpsilon(config.guidedFilterEpsilon());
     setThresholdingMethod(config.thresholdingMethod());
     setPTileValue(config.pTileValue());
+    setLocalThresholdRadius(config.localThresholdRadius());
+    setLocalThresholdWeight(config.localThresholdWeight());
+    setClusterThresholdCount(config.clusterThresholdCount());
+    setForegroundClass(config.foregroundClass());
+    // move the bound on the side the thresholds go first, so that they stay ordered
+    if (config.cannyLowThreshold() > d->cannyHighThreshold)
+    {
+        setCannyHighThreshold(config.cannyHighThreshold());
+        setCannyLowThreshold(config.cannyLowThreshold());
+    }
+    else
+    {
+        setCannyLowThreshold(config.cannyLowThreshold());
+        setCannyHighThreshold(config.cannyHighThreshold());
+    }
     setEdgeDetectionMethod(config.edgeDetectionMethod());
     setCircleFitMethod(config.circleFitMethod());
     setErrorCorrectionMethod(config.errorCorrectionMethod());
@@ -505,6 +671,21 @@ void Processor::setGaussianSigma(qreal sigma)
     d->updateFilteredImage();
 }
 
+qreal Processor::recursiveGaussianCutoff() const
+{
+    return d->recursiveGaussianCutoff;
+}
+
+void Processor::setRecursiveGaussianCutoff(qreal sigma)
+{
+    if (qFuzzyIsNull(d->recursiveGaussianCutoff - sigma))
+        return;
+    d->recursiveGaussianCutoff = sigma;
+    emit recursiveGaussianCutoffChanged(d->recursiveGaussianCutoff);
+
+    d->updateFilteredImage();
+}
+
 qreal Processor::colorRadius() const
 {
     return d->colorRadius;
@@ -535,6 +716,36 @@ void Processor::setMaxLevel(uint level)
     d->updateFilteredImage();
 }
 
+bool Processor::meanShiftUntilConverged() const
+{
+    return d->meanShiftUntilConverged;
+}
+
+void Processor::setMeanShiftUntilConverged(bool untilConverged)
+{
+    if (d->meanShiftUntilConverged == untilConverged)
+        return;
+    d->meanShiftUntilConverged = untilConverged;
+    emit meanShiftUntilConvergedChanged(d->meanShiftUntilConverged);
+
+    d->updateFilteredImage();
+}
+
+qreal Processor::guidedFilterEpsilon() const
+{
+    return d->guidedFilterEpsilon;
+}
+
+void Processor::setGuidedFilterEpsilon(qreal epsilon)
+{
+    if (qFuzzyIsNull(d->guidedFilterEpsilon - epsilon))
+        return;
+    d->guidedFilterEpsilon = epsilon;
+    emit guidedFilterEpsilonChanged(d->guidedFilterEpsilon);
+
+    d->updateFilteredImage();
+}
+
 qreal Processor::pTileValue() const
 {
     return d->pTileValue;
@@ -550,6 +761,108 @@ void Processor::setPTileValue(qreal value)
     d->updateThreshold();
 }
 
+uint Processor::localThresholdRadius() const
+{
+    return d->localThresholdRadius;
+}
+
+void Processor::setLocalThresholdRadius(uint radius)
+{
+    if (d->localThresholdRadius == radius)
+        return;
+    d->localThresholdRadius = radius;
+    emit localThresholdRadiusChanged(d->localThresholdRadius);
+
+    d->updateThreshold();
+}
+
+qreal Processor::localThresholdWeight() const
+{
+    return d->localThresholdWeight;
+}
+
+void Processor::setLocalThresholdWeight(qreal weight)
+{
+    if (qFuzzyIsNull(d->localThresholdWeight - weight))
+        return;
+    d->localThresholdWeight = weight;
+    emit localThresholdWeightChanged(d->localThresholdWeight);
+
+    d->updateThreshold();
+}
+
+uint Processor::clusterThresholdCount() const
+{
+    return d->clusterThresholdCount;
+}
+
+void Processor::setClusterThresholdCount(uint count)
+{
+    if (d->clusterThresholdCount == count)
+        return;
+    d->clusterThresholdCount = count;
+    emit clusterThresholdCountChanged(d->clusterThresholdCount);
+
+    d->updateThreshold();
+}
+
+uint Processor::foregroundClass() const
+{
+    return d->foregroundClass;
+}
+
+void Processor::setForegroundClass(uint index)
+{
+    if (d->foregroundClass == index)
+        return;
+    d->foregroundClass = index;
+    emit foregroundClassChanged(d->foregroundClass);
+
+    d->updateThreshold();
+}
+
+qreal Processor::cannyLowThreshold() const
+{
+    return d->cannyLowThreshold;
+}
+
+void Processor::setCannyLowThreshold(qreal threshold)
+{
+    if (qFuzzyIsNull(d->cannyLowThreshold - threshold))
+        return;
+    if (threshold > d->cannyHighThreshold)
+    {
+        qWarning() << __func__ << ": The low threshold" << threshold
+                   << "is above the high threshold" << d->cannyHighThreshold;
+        return;
+    }
+    d->cannyLowThreshold = threshold;
+    emit cannyLowThresholdChanged(d->cannyLowThreshold);
+
+    d->updateEdgeImage();
+}
+
+qreal Processor::cannyHighThreshold() const
+{
+    return d->cannyHighThreshold;
+}
+
+void Processor::setCannyHighThreshold(qreal threshold)
+{
+    if (qFuzzyIsNull(d->cannyHighThreshold - threshold))
+        return;
+    if (threshold < d->cannyLowThreshold)
+    {
+        qWarning() << __func__ << ": The high threshold" << threshold
+                   << "is below the low threshold" << d->cannyLowThreshold;
+        return;
+    }
+    d->cannyHighThreshold = threshold;
+    emit cannyHighThresholdChanged(d->cannyHighThreshold);
+
+    d->updateEdgeImage();
+}
+
 void Processor::saveConfigurations(const QString& group) const
 {
     Configuration config = configurations();
@@ -569,5 +882,6 @@ void Processor::setThreshold(int threshold)
     d->threshold = threshold;
     emit thresholdChanged(d->threshold);
 
-    setBinaryImage(MEMS::binarize(d->filtered,d->threshold));
+    if (d->threshold >= 0)
+        setBinaryImage(MEMS::binarize(d->filtered,d->threshold));
 }
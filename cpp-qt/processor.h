@@ -57,9 +57,18 @@ class Processor : public QObject
     Q_PROPERTY(Configuration::ErrorCorrectionMethod errorCorrectionMethod READ errorCorrectionMethod WRITE setErrorCorrectionMethod NOTIFY errorCorrectionMethodChanged)
     Q_PROPERTY(uint filterRadius READ filterRadius WRITE setFilterRadius NOTIFY filterRadiusChanged)
     Q_PROPERTY(qreal gaussianSigma READ gaussianSigma WRITE setGaussianSigma NOTIFY gaussianSigmaChanged)
+    Q_PROPERTY(qreal recursiveGaussianCutoff READ recursiveGaussianCutoff WRITE setRecursiveGaussianCutoff NOTIFY recursiveGaussianCutoffChanged)
     Q_PROPERTY(qreal colorRadius READ colorRadius WRITE setColorRadius NOTIFY colorRadiusChanged)
     Q_PROPERTY(uint maxLevel READ maxLevel WRITE setMaxLevel NOTIFY maxLevelChanged)
+    Q_PROPERTY(bool meanShiftUntilConverged READ meanShiftUntilConverged WRITE setMeanShiftUntilConverged NOTIFY meanShiftUntilConvergedChanged)
+    Q_PROPERTY(qreal guidedFilterEpsilon READ guidedFilterEpsilon WRITE setGuidedFilterEpsilon NOTIFY guidedFilterEpsilonChanged)
     Q_PROPERTY(qreal pTileValue READ pTileValue WRITE setPTileValue NOTIFY pTileValueChanged)
+    Q_PROPERTY(uint localThresholdRadius READ localThresholdRadius WRITE setLocalThresholdRadius NOTIFY localThresholdRadiusChanged)
+    Q_PROPERTY(qreal localThresholdWeight READ localThresholdWeight WRITE setLocalThresholdWeight NOTIFY localThresholdWeightChanged)
+    Q_PROPERTY(uint clusterThresholdCount READ clusterThresholdCount WRITE setClusterThresholdCount NOTIFY clusterThresholdCountChanged)
+    Q_PROPERTY(uint foregroundClass READ foregroundClass WRITE setForegroundClass NOTIFY foregroundClassChanged)
+    Q_PROPERTY(qreal cannyLowThreshold READ cannyLowThreshold WRITE setCannyLowThreshold NOTIFY cannyLowThresholdChanged)
+    Q_PROPERTY(qreal cannyHighThreshold READ cannyHighThreshold WRITE setCannyHighThreshold NOTIFY cannyHighThresholdChanged)
     Q_PROPERTY(int threshold READ threshold NOTIFY thresholdChanged)
 
 public:
@@ -80,11 +89,20 @@ public:
     Configuration::FilterMethod filterMethod() const;
     uint filterRadius() const;
     qreal gaussianSigma() const;
+    qreal recursiveGaussianCutoff() const;
     qreal colorRadius() const;
     uint maxLevel() const;
+    bool meanShiftUntilConverged() const;
+    qreal guidedFilterEpsilon() const;
 
     Configuration::ThresholdingMethod thresholdingMethod() const;
     qreal pTileValue() const;
+    uint localThresholdRadius() const;
+    qreal localThresholdWeight() const;
+    uint clusterThresholdCount() const;
+    uint foregroundClass() const;
+    qreal cannyLowThreshold() const;
+    qreal cannyHighThreshold() const;
     int threshold() const;
 
     Configuration::EdgeDetectionMethod edgeDetectionMethod() const;
@@ -108,9 +126,18 @@ signals:
     void errorCorrectionMethodChanged(Configuration::ErrorCorrectionMethod method);
     void filterRadiusChanged(uint radius);
     void gaussianSigmaChanged(qreal sigma);
+    void recursiveGaussianCutoffChanged(qreal sigma);
     void colorRadiusChanged(qreal radius);
     void maxLevelChanged(uint level);
+    void meanShiftUntilConvergedChanged(bool untilConverged);
+    void guidedFilterEpsilonChanged(qreal epsilon);
     void pTileValueChanged(qreal value);
+    void localThresholdRadiusChanged(uint radius);
+    void localThresholdWeightChanged(qreal weight);
+    void clusterThresholdCountChanged(uint count);
+    void foregroundClassChanged(uint index);
+    void cannyLowThresholdChanged(qreal threshold);
+    void cannyHighThresholdChanged(qreal threshold);
     void thresholdChanged(int threshold);
 
 public slots:
@@ -123,9 +150,18 @@ public slots:
     void setErrorCorrectionMethod(Configuration::ErrorCorrectionMethod method);
     void setFilterRadius(uint radius);
     void setGaussianSigma(qreal sigma);
+    void setRecursiveGaussianCutoff(qreal sigma);
     void setColorRadius(qreal radius);
     void setMaxLevel(uint level);
+    void setMeanShiftUntilConverged(bool untilConverged);
+    void setGuidedFilterEpsilon(qreal epsilon);
     void setPTileValue(qreal value);
+    void setLocalThresholdRadius(uint radius);
+    void setLocalThresholdWeight(qreal weight);
+    void setClusterThresholdCount(uint count);
+    void setForegroundClass(uint index);
+    void setCannyLowThreshold(qreal threshold);
+    void setCannyHighThreshold(qreal threshold);
 
     void saveConfigurations(const QString& group) const;
 
@@ -133,6 +169,7 @@ private slots: // internal
     void setFilteredImage(const QImage& filtered);
     void setBinaryImage(const QImage& binary);
     void setEdgeImage(const QImage& edge);
+    void setEdgePixels(const QVector<QPoint>& edgePixels, const QSize& size);
     void setCircleImage(const QImage& circle);
     void setCircle(const MEMS::CircleData& circle);
     void setThreshold(int threshold);
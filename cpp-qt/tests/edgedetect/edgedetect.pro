@@ -0,0 +1,5 @@
+TARGET = tst_edgedetect
+
+include(../tests.pri)
+
+SOURCES += tst_edgedetect.cpp
@@ -0,0 +1,72 @@
+/**
+ ** MIT License
+ **
+ ** This file is part of the MEMS-oriented-image-testing-technology project.
+ ** Copyright (c) 2018 Lu <miroox@outlook.com>.
+ **
+ ** Permission is hereby granted, free of charge, to any person obtaining a copy
+ ** of this software and associated documentation files (the "Software"), to deal
+ ** in the Software without restriction, including without limitation the rights
+ ** to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ ** copies of the Software, and to permit persons to whom the Software is
+ ** furnished to do so, subject to the following conditions:
+ **
+ ** The above copyright notice and this permission notice shall be included in all
+ ** copies or substantial portions of the Software.
+ **
+ ** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ ** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ ** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ ** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ ** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM
+ ** OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ ** SOFTWARE.
+ **/
+
+#include <QtTest>
+#include <QImage>
+#include <QVector>
+#include <QPoint>
+#include "edgedetect.h"
+
+using namespace MEMS;
+
+class TestEdgeDetect : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void cannyKeepsEdgesOnTheBorder();
+};
+
+void TestEdgeDetect::cannyKeepsEdgesOnTheBorder()
+{
+    const int width = 20, height = 12;
+    for (int side=0; side<4; ++side)
+    {
+        // a dark line along one side of a bright image
+        QImage image(width,height,QImage::Format_Grayscale8);
+        for (int y=0; y<height; ++y)
+        {
+            uchar* line = image.scanLine(y);
+            for (int x=0; x<width; ++x)
+            {
+                const bool dark = side==0 ? x==0 : side==1 ? y==0 : side==2 ? x==width-1 : y==height-1;
+                line[x] = dark ? 0 : 200;
+            }
+        }
+
+        // one edge pixel across the step in every row or column
+        const bool vertical = side%2 == 0;
+        QVector<int> crossings(vertical ? height : width,0);
+        for (const QPoint& point : cannyPoints(image,10,30))
+        {
+            ++crossings[vertical ? point.y() : point.x()];
+        }
+        QCOMPARE(crossings,QVector<int>(crossings.size(),1));
+    }
+}
+
+QTEST_APPLESS_MAIN(TestEdgeDetect)
+
+#include "tst_edgedetect.moc"
@@ -0,0 +1,5 @@
+TARGET = tst_imagefilter
+
+include(../tests.pri)
+
+SOURCES += tst_imagefilter.cpp
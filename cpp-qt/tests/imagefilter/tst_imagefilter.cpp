@@ -0,0 +1,230 @@
+/**
+ ** MIT License
+ **
+ ** This file is part of the MEMS-oriented-image-testing-technology project.
+ ** Copyright (c) 2018 Lu <miroox@outlook.com>.
+ **
+ ** Permission is hereby granted, free of charge, to any person obtaining a copy
+ ** of this software and associated documentation files (the "Software"), to deal
+ ** in the Software without restriction, including without limitation the rights
+ ** to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ ** copies of the Software, and to permit persons to whom the Software is
+ ** furnished to do so, subject to the following conditions:
+ **
+ ** The above copyright notice and this permission notice shall be included in all
+ ** copies or substantial portions of the Software.
+ **
+ ** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ ** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ ** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ ** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ ** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM
+ ** OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ ** SOFTWARE.
+ **/
+
+#include <QtTest>
+#include <QImage>
+#include <QThreadPool>
+#include <algorithm>
+#include <functional>
+#include <random>
+#include "imagefilter.h"
+#include "edgedetect.h"
+#include "testimages.h"
+
+using namespace MEMS;
+
+/*!
+    \internal
+
+    The gray \a image as RGB32, with the blue channel of its first pixel flipped so that
+    the filters cannot take their gray path for it.
+ */
+static QImage notAllGray(const QImage& image)
+{
+    QImage color = image.convertToFormat(QImage::Format_RGB32);
+    const QRgb pixel = color.pixel(0,0);
+    color.setPixel(0,0,qRgb(qRed(pixel),qGreen(pixel),qBlue(pixel)^1));
+    return color;
+}
+
+/*!
+    \internal
+
+    The red channel of \a image as a gray image.
+ */
+static QImage redChannel(const QImage& image)
+{
+    const QImage color = image.convertToFormat(QImage::Format_RGB32);
+    QImage red(image.size(),QImage::Format_Grayscale8);
+    for (int y=0; y<color.height(); ++y)
+    {
+        const QRgb* colorLine = reinterpret_cast<const QRgb*>(color.constScanLine(y));
+        uchar* redLine = red.scanLine(y);
+        for (int x=0; x<color.width(); ++x)
+        {
+            redLine[x] = static_cast<uchar>(qRed(colorLine[x]));
+        }
+    }
+    return red;
+}
+
+class TestImageFilter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void parallelRowsMatchSerial();
+    void grayPathMatchesRgbPath();
+    void colorMedianIsWindowPixel();
+
+private:
+    int threadCount = 0;
+};
+
+void TestImageFilter::initTestCase()
+{
+    threadCount = QThreadPool::globalInstance()->maxThreadCount();
+}
+
+void TestImageFilter::cleanupTestCase()
+{
+    QThreadPool::globalInstance()->setMaxThreadCount(threadCount);
+}
+
+void TestImageFilter::parallelRowsMatchSerial()
+{
+    const MatrixKernel laplacian({{0,1,0},{1,-4,1},{0,1,0}});
+    const QRgb padding = qRgb(3,4,5);
+    const QVector<::std::function<QImage(const QImage&)>> filters = {
+        [&](const QImage& image){ return convolve(image,laplacian,PaddingType::Reflected); },
+        [&](const QImage& image){ return convolve(image,laplacian,padding); },
+        [](const QImage& image){ return sobelOperator(image); },
+        [](const QImage& image){ return gaussianFilter(image,4,2.); },
+        [&](const QImage& image){ return gaussianFilter(image,4,2.,padding); },
+        [](const QImage& image){ return boxFilter(image,3); },
+        [&](const QImage& image){ return boxFilter(image,3,padding); },
+        [](const QImage& image){ return medianFilter(image,2); },
+        [](const QImage& image){ return medianFilter(image,15); },
+        [](const QImage& image){ return meanShiftFilter(image,2,0.1,2); },
+    };
+
+    // odd sizes, so that the rows do not split evenly between the threads
+    ::std::mt19937 generator(5);
+    const QImage images[] = {randomGrayImage(generator,301,257,QImage::Format_Grayscale8),
+                             randomColorImage(generator,203,150)};
+    for (const QImage& image : images)
+    {
+        for (const auto& filter : filters)
+        {
+            QThreadPool::globalInstance()->setMaxThreadCount(1);
+            const QImage serial = filter(image);
+            QThreadPool::globalInstance()->setMaxThreadCount(16);
+            const QImage parallel = filter(image);
+            QVERIFY(!serial.isNull());
+            QCOMPARE(parallel,serial);
+        }
+    }
+}
+
+void TestImageFilter::grayPathMatchesRgbPath()
+{
+    MatrixKernel kernel({{1,2,0},{0,1,-1},{0.5,0,1}});
+    kernel /= 4.5;
+    const MatrixKernel kerX({{-1,0,1},{-2,0,2},{-1,0,1}});
+    const MatrixKernel kerY = kerX.transposed();
+    const MatrixKernel binomial({{1./16,2./16,1./16},{2./16,4./16,2./16},{1./16,2./16,1./16}});
+
+    QVector<::std::function<QImage(const QImage&)>> filters;
+    for (PaddingType padding : {PaddingType::Fixed, PaddingType::Periodic, PaddingType::Reflected})
+    {
+        filters << [=](const QImage& image){ return convolve(image,kernel,padding); }
+                << [=](const QImage& image){ return convolveXY(image,kerX,kerY,padding); }
+                << [=](const QImage& image){ return gaussianFilter(image,3,padding); }
+                << [=](const QImage& image){ return boxFilter(image,2,padding); }
+                << [=](const QImage& image){ return convolve(image,kernel.quantized(),padding); }
+                << [=](const QImage& image){ return convolve(image,binomial.quantized(),padding); };
+    }
+    const QRgb grayPadding = qRgb(77,77,77);
+    filters << [=](const QImage& image){ return convolve(image,kernel,grayPadding); }
+            << [=](const QImage& image){ return convolveXY(image,kerX,kerY,grayPadding); }
+            << [=](const QImage& image){ return gaussianFilter(image,3,grayPadding); }
+            << [=](const QImage& image){ return boxFilter(image,2,grayPadding); }
+            << [=](const QImage& image){ return convolve(image,kernel.quantized(),grayPadding); };
+    const QVector<::std::function<QImage(const QImage&)>> edgeOperators = {
+        [](const QImage& image){ return sobelOperator(image); },
+        [](const QImage& image){ return sobelOperator(image,GradientNorm::Manhattan); },
+        [](const QImage& image){ return scharrOperator(image); },
+        [](const QImage& image){ return prewittOperator(image); },
+        [](const QImage& image){ return laplacianOperator(image); },
+    };
+    filters << edgeOperators;
+
+    // the filters hand back the format of their input, which is only lossless for 8-bit gray
+    ::std::mt19937 generator(8);
+    const QImage images[] = {randomGrayImage(generator,53,37,QImage::Format_Grayscale8),
+                             randomGrayImage(generator,40,29,QImage::Format_Indexed8)};
+    for (const QImage& gray : images)
+    {
+        QVERIFY(gray.allGray());
+        const QImage color = notAllGray(gray);
+        QVERIFY(!color.allGray());
+        for (const auto& filter : filters)
+        {
+            QCOMPARE(redChannel(filter(gray)),redChannel(filter(color)));
+        }
+
+        // mean shift measures the distance of all three channels, so the flipped blue bit
+        // moves the result up to spatialRadius*maxLevel pixels away from the first pixel
+        const uint spatialRadius = 2, maxLevel = 2;
+        const int reach = spatialRadius*maxLevel;
+        const QRect unaffected(0,reach+1,gray.width(),gray.height()-reach-1);
+        QCOMPARE(redChannel(meanShiftFilter(gray,spatialRadius,0.1,maxLevel)).copy(unaffected),
+                 redChannel(meanShiftFilter(color,spatialRadius,0.1,maxLevel)).copy(unaffected));
+    }
+
+    // binary images, as edge detection gets them after thresholding
+    const QImage binary = randomGrayImage(generator,64,48,QImage::Format_Mono);
+    QVERIFY(binary.allGray());
+    for (const auto& edgeOperator : edgeOperators)
+    {
+        QCOMPARE(redChannel(edgeOperator(binary)),redChannel(edgeOperator(notAllGray(binary))));
+    }
+}
+
+void TestImageFilter::colorMedianIsWindowPixel()
+{
+    ::std::mt19937 generator(4);
+    const QImage image = randomColorImage(generator,60,45);
+    for (int radius : {1, 3, 12})
+    {
+        const QImage median = medianFilter(image,radius);
+        for (int y=0; y<image.height(); ++y)
+        {
+            for (int x=0; x<image.width(); ++x)
+            {
+                const QRgb pixel = median.pixel(x,y);
+                QVector<int> grays;
+                bool inWindow = false;
+                for (int yy=qMax(0,y-radius); yy<=qMin(image.height()-1,y+radius); ++yy)
+                {
+                    for (int xx=qMax(0,x-radius); xx<=qMin(image.width()-1,x+radius); ++xx)
+                    {
+                        grays.append(qGray(image.pixel(xx,yy)));
+                        inWindow = inWindow || image.pixel(xx,yy) == pixel;
+                    }
+                }
+                ::std::sort(grays.begin(),grays.end());
+                QVERIFY(inWindow);
+                QCOMPARE(qGray(pixel),grays.at(grays.size()/2));
+            }
+        }
+    }
+}
+
+QTEST_APPLESS_MAIN(TestImageFilter)
+
+#include "tst_imagefilter.moc"
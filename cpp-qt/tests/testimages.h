@@ -0,0 +1,77 @@
+/**
+ ** MIT License
+ **
+ ** This file is part of the MEMS-oriented-image-testing-technology project.
+ ** Copyright (c) 2018 Lu <miroox@outlook.com>.
+ **
+ ** Permission is hereby granted, free of charge, to any person obtaining a copy
+ ** of this software and associated documentation files (the "Software"), to deal
+ ** in the Software without restriction, including without limitation the rights
+ ** to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ ** copies of the Software, and to permit persons to whom the Software is
+ ** furnished to do so, subject to the following conditions:
+ **
+ ** The above copyright notice and this permission notice shall be included in all
+ ** copies or substantial portions of the Software.
+ **
+ ** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ ** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ ** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ ** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ ** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM
+ ** OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ ** SOFTWARE.
+ **/
+
+
+#ifndef TESTIMAGES_H
+#define TESTIMAGES_H
+
+#include <QImage>
+#include <QtGlobal>
+#include <random>
+
+/*!
+    \internal
+
+    A \a width by \a height image of random colors drawn by \a generator, converted to
+    \a format.
+ */
+inline QImage randomColorImage(::std::mt19937& generator, int width, int height,
+                               QImage::Format format = QImage::Format_RGB32)
+{
+    QImage image(width,height,QImage::Format_RGB32);
+    for (int y=0; y<height; ++y)
+    {
+        QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x=0; x<width; ++x)
+        {
+            line[x] = qRgb(generator()%0x100,generator()%0x100,generator()%0x100);
+        }
+    }
+    return image.convertToFormat(format);
+}
+
+/*!
+    \internal
+
+    A \a width by \a height gray image drawn by \a generator: a dark disc on a bright
+    background with noise on both, converted to \a format.
+ */
+inline QImage randomGrayImage(::std::mt19937& generator, int width, int height, QImage::Format format)
+{
+    QImage image(width,height,QImage::Format_Grayscale8);
+    for (int y=0; y<height; ++y)
+    {
+        uchar* line = image.scanLine(y);
+        for (int x=0; x<width; ++x)
+        {
+            const qreal dx = x-width/2., dy = y-height/2.;
+            const int base = dx*dx+dy*dy < width*width/9. ? 40 : 190;
+            line[x] = static_cast<uchar>(qBound(0,base+int(generator()%60)-30,0xff));
+        }
+    }
+    return image.convertToFormat(format);
+}
+
+#endif // TESTIMAGES_H
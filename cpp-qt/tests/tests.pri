@@ -0,0 +1,27 @@
+# Common settings of the unit tests, which build the algorithms from the sources of the application
+
+CONFIG += c++14 testcase console
+CONFIG -= app_bundle
+QT += core gui concurrent testlib
+QT -= widgets
+
+SOURCE_DIR = $$PWD/..
+INCLUDEPATH += $$SOURCE_DIR $$PWD
+DEPENDPATH += $$SOURCE_DIR
+
+SOURCES += \
+    $$SOURCE_DIR/imagefilter.cpp \
+    $$SOURCE_DIR/thresholding.cpp \
+    $$SOURCE_DIR/edgedetect.cpp \
+    $$SOURCE_DIR/fft.cpp \
+    $$SOURCE_DIR/progressupdater.cpp
+
+HEADERS += \
+    $$SOURCE_DIR/imagefilter.h \
+    $$SOURCE_DIR/thresholding.h \
+    $$SOURCE_DIR/binarize.hpp \
+    $$SOURCE_DIR/edgedetect.h \
+    $$SOURCE_DIR/fft.h \
+    $$SOURCE_DIR/utils.h \
+    $$SOURCE_DIR/progressupdater.h \
+    $$PWD/testimages.h
@@ -0,0 +1,10 @@
+# Unit tests of the MEMS-oriented-image-testing-technology algorithms
+#
+# qmake tests.pro && make check
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    edgedetect \
+    imagefilter \
+    thresholding
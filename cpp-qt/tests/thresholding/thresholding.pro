@@ -0,0 +1,5 @@
+TARGET = tst_thresholding
+
+include(../tests.pri)
+
+SOURCES += tst_thresholding.cpp
@@ -0,0 +1,220 @@
+/**
+ ** MIT License
+ **
+ ** This file is part of the MEMS-oriented-image-testing-technology project.
+ ** Copyright (c) 2018 Lu <miroox@outlook.com>.
+ **
+ ** Permission is hereby granted, free of charge, to any person obtaining a copy
+ ** of this software and associated documentation files (the "Software"), to deal
+ ** in the Software without restriction, including without limitation the rights
+ ** to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ ** copies of the Software, and to permit persons to whom the Software is
+ ** furnished to do so, subject to the following conditions:
+ **
+ ** The above copyright notice and this permission notice shall be included in all
+ ** copies or substantial portions of the Software.
+ **
+ ** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ ** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ ** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ ** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ ** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM
+ ** OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ ** SOFTWARE.
+ **/
+
+
+#include <QtTest>
+#include <QImage>
+#include <QVector>
+#include <cmath>
+#include <limits>
+#include <random>
+#include "thresholding.h"
+#include "binarize.hpp"
+#include "progressupdater.h"
+#include "testimages.h"
+
+using namespace MEMS;
+
+/*!
+    \internal
+
+    The fuzziness threshold as first implemented, summing the entropy of both classes
+    over all the levels for every candidate threshold.
+ */
+static int nestedLoopFuzzinessThreshold(const Histogram& histogram)
+{
+    using ::std::log;
+    using ::std::abs;
+
+    const int histoSize = histogram.length();
+    int first, last;
+    for (first=0; first<histoSize && histogram[first]==0; ++first);
+    for (last=histoSize-1; last>first && histogram[last]==0; --last);
+    if (first==last || first+1==last)
+        return first;
+
+    QVector<qreal> s(last+1,0);
+    QVector<qreal> w(last+1,0);
+    s[0] = histogram[0];
+    for (int i= ::std::max(first,1); i<=last; ++i)
+    {
+        s[i] = s.at(i-1) + histogram.at(i);
+        w[i] = w.at(i-1) + i*histogram.at(i);
+    }
+
+    qreal c = last-first;
+    QVector<qreal> s_mu(last-first+1);
+    for (int i=1; i<s_mu.length(); ++i)
+    {
+        qreal mu = 1/(1+i/c);
+        s_mu[i] = -mu*log(mu) - (1-mu)*log(1-mu);
+    }
+
+    int threshold = 0;
+    qreal bestEntropy = ::std::numeric_limits<qreal>::max();
+    for (int i=first; i<last; ++i)
+    {
+        qreal entropy = 0.;
+        int mu = static_cast<int>(w.at(i)/s.at(i));
+        for (int j=first; j<=i; ++j)
+        {
+            entropy += s_mu.at(abs(j-mu))*histogram.at(j);
+        }
+        mu = static_cast<int>((w.at(last)-w.at(i))/(s.at(last)-s.at(i)));
+        for (int j=i+1; j<=last; ++j)
+        {
+            entropy += s_mu.at(abs(j-mu))*histogram.at(j);
+        }
+        if (bestEntropy > entropy)
+        {
+            bestEntropy = entropy;
+            threshold = i;
+        }
+    }
+
+    return threshold;
+}
+
+/*!
+    \internal
+
+    A histogram of \a levels levels drawn by \a generator, whose shape depends on \a kind:
+    uniform, bimodal, sparse, narrow, or two spikes at both ends.
+ */
+static Histogram randomHistogram(::std::mt19937& generator, int levels, int kind, int count)
+{
+    ::std::normal_distribution<qreal> dark(levels*0.3,levels*0.05);
+    ::std::normal_distribution<qreal> bright(levels*0.7,levels*0.08);
+    ::std::normal_distribution<qreal> narrow(levels*0.5,2);
+    Histogram histogram(levels,0);
+    for (int k=0; k<count; ++k)
+    {
+        int level = 0;
+        ::std::size_t weight = 1;
+        switch (kind)
+        {
+        case 0:
+            level = generator()%levels;
+            break;
+        case 1:
+            level = static_cast<int>(k%3 ? dark(generator) : bright(generator));
+            break;
+        case 2:
+            level = (generator()%16)*(levels/16);
+            break;
+        case 3:
+            level = static_cast<int>(narrow(generator));
+            break;
+        default:
+            level = generator()%2 ? generator()%8 : levels-1-generator()%8;
+            weight += generator()%1000;
+            break;
+        }
+        if (level >= 0 && level < levels)
+            histogram[level] += weight;
+    }
+    return histogram;
+}
+
+class TestThresholding : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void fuzzinessThresholdMatchesNestedLoops();
+    void emptyHistogramGivesZero();
+    void binarizeMatchesPredicate();
+
+private:
+    ProgressUpdater progressUpdater;
+};
+
+void TestThresholding::fuzzinessThresholdMatchesNestedLoops()
+{
+    ::std::mt19937 generator(5);
+    for (int t=0; t<5000; ++t)
+    {
+        const int levels = t%10==0 ? 1024 : 256;
+        const Histogram histogram = randomHistogram(generator,levels,t%5,t%7==0 ? 3 : 5000);
+        QCOMPARE(fuzzinessThreshold(histogram),nestedLoopFuzzinessThreshold(histogram));
+    }
+
+    Histogram few(256,0);
+    few[7] = 5;
+    QCOMPARE(fuzzinessThreshold(few),nestedLoopFuzzinessThreshold(few));
+    few[8] = 3;
+    QCOMPARE(fuzzinessThreshold(few),nestedLoopFuzzinessThreshold(few));
+    few[200] = 3;
+    QCOMPARE(fuzzinessThreshold(few),nestedLoopFuzzinessThreshold(few));
+}
+
+void TestThresholding::emptyHistogramGivesZero()
+{
+    const HistogramStats empty(Histogram(256,0));
+    QVERIFY(empty.isEmpty());
+    QCOMPARE(meanThreshold(empty),0);
+    QCOMPARE(pTileThreshold(empty,0.5),0);
+    QCOMPARE(clusterThreshold(empty),0);
+    QCOMPARE(clusterThresholds(empty,3),QVector<int>(3,0));
+    QCOMPARE(momentsThreshold(empty),0);
+    QCOMPARE(fuzzinessThreshold(empty),0);
+    QCOMPARE(entropyThreshold(empty),0);
+    QCOMPARE(minimumErrorThreshold(empty),0);
+    QCOMPARE(triangleThreshold(empty),0);
+}
+
+void TestThresholding::binarizeMatchesPredicate()
+{
+    const QImage::Format formats[] = {QImage::Format_Grayscale8, QImage::Format_Indexed8,
+                                      QImage::Format_RGB32, QImage::Format_ARGB32,
+                                      QImage::Format_Mono};
+    ::std::mt19937 generator(22);
+    for (int width : {1, 7, 15, 16, 17, 33, 100})
+    {
+        for (QImage::Format format : formats)
+        {
+            const QImage image = randomColorImage(generator,width,9,format);
+            for (int threshold : {0, 1, 77, 128, 200, 254, 255})
+            {
+                QCOMPARE(binarize(image,threshold),
+                         binarize(image,[=](QRgb pixel){ return qGray(pixel)>threshold; }));
+
+                const QVector<int> thresholds{threshold/3, threshold};
+                for (int foreground=0; foreground<=thresholds.size(); ++foreground)
+                {
+                    QCOMPARE(binarize(image,thresholds,foreground),
+                             binarize(image,[&](QRgb pixel){
+                                 int gray = qGray(pixel);
+                                 return (gray>thresholds.at(0)) + (gray>thresholds.at(1)) == foreground;
+                             }));
+                }
+            }
+        }
+    }
+}
+
+QTEST_APPLESS_MAIN(TestThresholding)
+
+#include "tst_thresholding.moc"
@@ -36,9 +36,13 @@
 #include <QImage>
 #include <QColor>
 #include <QVector>
+#include <QMutex>
 #include <cmath>
 #include <limits>
 #include <algorithm>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "utils.h"
 
 namespace MEMS {
@@ -60,15 +64,149 @@ static constexpr ::std::size_t ColorValueRange = 0x100;
            Moment-preserving thresholding.
     \value Fuzziness
            Thresholding by minimizing the measures of fuzziness.
+    \value Entropy
+           Thresholding by maximizing the entropies of the classes.
+    \value MinimumError
+           Minimum error thresholding.
+    \value Triangle
+           Thresholding by the triangle of the histogram peak.
+    \value MultiCluster
+           Multi-level Otsu's method, keeping the brightest of three classes.
+    \value MultiOtsu
+           Alias of MultiCluster.
 
     \omitvalue Cluster
     \omitvalue Otsu
     \omitvalue Mean
     \omitvalue Moments
     \omitvalue Fuzziness
+    \omitvalue Entropy
+    \omitvalue MinimumError
+    \omitvalue Triangle
+    \omitvalue MultiCluster
+    \omitvalue MultiOtsu
  */
 
 
+/*!
+    \class HistogramStats
+    \brief The HistogramStats class holds the cumulative counts and moments of a histogram.
+
+    The tables are computed once in the constructor, so that every thresholding method
+    can evaluate the statistics of a class of levels in constant time,
+    and switching between the methods does not pass over the histogram again.
+ */
+
+/*!
+    Compute the cumulative tables of \a histogram.
+ */
+HistogramStats::HistogramStats(const Histogram& histogram)
+    : hist(histogram)
+{
+    using ::std::log;
+
+    const int histoSize = histogram.length();
+    for (QVector<qreal>& moment : moments)
+    {
+        moment.resize(histoSize);
+    }
+    entropies.resize(histoSize);
+
+    qreal sums[MomentOrders] = {};
+    qreal entropy = 0.;
+    for (int i=0; i<histoSize; ++i)
+    {
+        const qreal count = histogram.at(i);
+        qreal power = count;
+        for (int order=0; order<MomentOrders; ++order)
+        {
+            sums[order] += power;
+            moments[order][i] = sums[order];
+            power *= i;
+        }
+        if (count > 0)
+            entropy += count*log(count);
+        entropies[i] = entropy;
+    }
+
+    for (firstLevel=0; firstLevel<histoSize && histogram.at(firstLevel)==0; ++firstLevel);
+    for (lastLevel=histoSize-1; lastLevel>firstLevel && histogram.at(lastLevel)==0; --lastLevel);
+}
+
+/*!
+    The histogram.
+ */
+const Histogram& HistogramStats::histogram() const
+{
+    return hist;
+}
+
+/*!
+    The number of levels of the histogram.
+ */
+int HistogramStats::levels() const
+{
+    return hist.length();
+}
+
+/*!
+    Whether the histogram counts no pixels, in which case first() is after last().
+ */
+bool HistogramStats::isEmpty() const
+{
+    return firstLevel > lastLevel;
+}
+
+/*!
+    The first non-empty level.
+ */
+int HistogramStats::first() const
+{
+    return firstLevel;
+}
+
+/*!
+    The last non-empty level, or first() if there is at most one.
+ */
+int HistogramStats::last() const
+{
+    return lastLevel;
+}
+
+/*!
+    The number of pixels.
+ */
+qreal HistogramStats::total() const
+{
+    return hist.isEmpty() ? 0. : moments[0].last();
+}
+
+/*!
+    The number of pixels of the levels [0, \a level].
+ */
+qreal HistogramStats::count(int level) const
+{
+    return moments[0].at(level);
+}
+
+/*!
+    The sum of the \a order-th power of the level, for the pixels of the levels [0, \a level].
+    The \a order is 0, 1, 2 or 3.
+ */
+qreal HistogramStats::moment(int order, int level) const
+{
+    Q_ASSERT_X(order>=0&&order<MomentOrders,__func__,"order of moment is out of range.");
+    return moments[order].at(level);
+}
+
+/*!
+    The sum of n*log(n) over the levels [0, \a level], where n is the number of pixels of the level.
+ */
+qreal HistogramStats::entropySum(int level) const
+{
+    return entropies.at(level);
+}
+
 /*!
     Use the mean level as the threshold.
  */
@@ -82,17 +220,18 @@ int meanThreshold(const QImage& image)
  */
 int meanThreshold(const Histogram& histogram)
 {
-    int total = 0;
-    int weighted = 0;
-    const int histoSize = histogram.length();
-    for (int i=0; i<histoSize; ++i)
-    {
-        total += histogram.at(i);
-        weighted += i*histogram.at(i);
+    return meanThreshold(HistogramStats(histogram));
+}
 
-        PROGRESS_UPDATE(i/histoSize);
-    }
-    return weighted/total;
+/*!
+    \overload meanThreshold
+ */
+int meanThreshold(const HistogramStats& stats)
+{
+    if (stats.isEmpty())
+        return 0;
+    const int last = stats.levels()-1;
+    return static_cast<int>(stats.moment(1,last)/stats.total());
 }
 
 /*!
@@ -109,27 +248,33 @@ int pTileThreshold(const QImage& image, qreal pValue)
  */
 int pTileThreshold(const Histogram& histogram, qreal pValue)
 {
-    Q_ASSERT_X(pValue>=0&&pValue<1,__func__,"p-value is out of range.");
+    return pTileThreshold(HistogramStats(histogram),pValue);
+}
 
-    const int histoSize = histogram.length();
-    ulong total = ::std::accumulate(histogram.cbegin(),histogram.cend(),ulong(0));
+/*!
+    \overload pTileThreshold
+ */
+int pTileThreshold(const HistogramStats& stats, qreal pValue)
+{
+    Q_ASSERT_X(pValue>=0&&pValue<1,__func__,"p-value is out of range.");
+    if (stats.isEmpty())
+        return 0;
 
-    int threshold = histoSize;
-    ulong partSum = 0;
-    for (int i=0; i<histoSize; ++i)
+    // the first level whose cumulative count exceeds the fraction
+    const qreal part = stats.total()*pValue;
+    int low = 0;
+    int high = stats.levels();
+    while (low < high)
     {
-        partSum += histogram.at(i);
-        if (partSum > total*pValue)
-        {
-            threshold = i;
-            break;
-        }
-
-        PROGRESS_UPDATE(i/histoSize);
+        const int middle = (low+high)/2;
+        if (stats.count(middle) > part)
+            high = middle;
+        else
+            low = middle+1;
     }
     PROGRESS_UPDATE(0.99);
 
-    return threshold;
+    return low;
 }
 
 /*!
@@ -153,26 +298,25 @@ int clusterThreshold(const QImage& image)
  */
 int clusterThreshold(const Histogram& histogram)
 {
-    const int histoSize = histogram.length();
-    qreal total = ::std::accumulate(histogram.cbegin(),histogram.cend(),qreal(0));
-    QVector<qreal> normalizedHistogram(histoSize);
+    return clusterThreshold(HistogramStats(histogram));
+}
 
-    qreal globalAverage = 0.;
-    for (int i=0; i<histoSize; ++i)
-    {
-        normalizedHistogram[i] = histogram.at(i)/total;
-        globalAverage += i*normalizedHistogram.at(i);
-    }
-    PROGRESS_UPDATE(0.5);
+/*!
+    \overload clusterThreshold
+ */
+int clusterThreshold(const HistogramStats& stats)
+{
+    if (stats.isEmpty())
+        return 0;
+    const qreal total = stats.total();
+    const qreal globalAverage = stats.moment(1,stats.levels()-1)/total;
 
     int threshold = 0;
     qreal maxVariance = 0.;
-    qreal average = 0.;
-    qreal fraction = 0.;
-    for (int i=0; i<histoSize ;++i)
+    for (int i=stats.first(); i<stats.last(); ++i)
     {
-        fraction += normalizedHistogram.at(i);
-        average += i*normalizedHistogram.at(i);
+        const qreal fraction = stats.count(i)/total;
+        const qreal average = stats.moment(1,i)/total;
         qreal distance = average/fraction - globalAverage;
         qreal variance = distance*distance*fraction/(1-fraction);
         if (variance > maxVariance)
@@ -186,6 +330,108 @@ int clusterThreshold(const Histogram& histogram)
     return threshold;
 }
 
+/*!
+    Perform multi-level clustering-based image thresholding, splitting the
+    gray levels into \a count + 1 classes by \a count ascending thresholds.
+    A pixel belongs to the class \c i if its level is above i thresholds.
+ */
+QVector<int> clusterThresholds(const QImage& image, int count)
+{
+/*!
+    \quotation
+    Liao, P-S, Chen, T-S & Chung, P-C (2001), "A fast algorithm for multilevel thresholding",
+    Journal of Information Science and Engineering 17(5): 713-727
+    \endquotation
+ */
+
+    return clusterThresholds(grayscaleHistogram(image),count);
+}
+
+/*!
+    \overload clusterThresholds
+ */
+QVector<int> clusterThresholds(const Histogram& histogram, int count)
+{
+    return clusterThresholds(HistogramStats(histogram),count);
+}
+
+/*!
+    \overload clusterThresholds
+ */
+QVector<int> clusterThresholds(const HistogramStats& stats, int count)
+{
+    Q_ASSERT_X(count>0,__func__,"count of thresholds is out of range.");
+    if (stats.isEmpty())
+        return QVector<int>(count,0);
+
+    const int first = stats.first();
+    const int last = stats.last();
+    const int levels = last-first+1;
+    QVector<int> thresholds(count);
+    if (levels <= count)
+    {
+        for (int k=0; k<count; ++k)
+        {
+            thresholds[k] = qMin(first+k,last);
+        }
+        return thresholds;
+    }
+
+    // maximizing the between-class variance is maximizing the sum of (Σ n_i*i)^2/(Σ n_i)
+    // over the classes, whose terms are tabulated for every range of levels [u, v]
+    const auto below = [&](int order, int u) {
+        return u>0 ? stats.moment(order,first+u-1) : 0.;
+    };
+    QVector<qreal> table(levels*levels,0.);
+    for (int u=0; u<levels; ++u)
+    {
+        const qreal countBelow = below(0,u);
+        const qreal sumBelow = below(1,u);
+        for (int v=u; v<levels; ++v)
+        {
+            const qreal classCount = stats.count(first+v)-countBelow;
+            const qreal classSum = stats.moment(1,first+v)-sumBelow;
+            if (classCount > 0)
+                table[u*levels+v] = classSum*classSum/classCount;
+        }
+    }
+    PROGRESS_UPDATE(0.5);
+
+    // best[k][v] is the best sum for the levels [0, v] split into k + 1 classes,
+    // and the k-th class of that split starts right after the level previous[k][v]
+    QVector<QVector<qreal>> best(count+1,QVector<qreal>(levels,-1.));
+    QVector<QVector<int>> previous(count+1,QVector<int>(levels,-1));
+    for (int v=0; v<levels; ++v)
+    {
+        best[0][v] = table.at(v);
+    }
+    for (int k=1; k<=count; ++k)
+    {
+        for (int v=k; v<levels; ++v)
+        {
+            for (int u=k-1; u<v; ++u)
+            {
+                const qreal sum = best.at(k-1).at(u)+table.at((u+1)*levels+v);
+                if (sum > best.at(k).at(v))
+                {
+                    best[k][v] = sum;
+                    previous[k][v] = u;
+                }
+            }
+        }
+    }
+
+    int v = levels-1;
+    for (int k=count; k>0; --k)
+    {
+        v = previous.at(k).at(v);
+        thresholds[k-1] = first+v;
+    }
+    PROGRESS_UPDATE(0.99);
+
+    return thresholds;
+}
+
 /*!
     Moment-preserving thresholding.
  */
@@ -206,22 +452,26 @@ int momentsThreshold(const QImage& image)
  */
 int momentsThreshold(const Histogram& histogram)
 {
+    return momentsThreshold(HistogramStats(histogram));
+}
+
+/*!
+    \overload momentsThreshold
+ */
+int momentsThreshold(const HistogramStats& stats)
+{
+    if (stats.isEmpty())
+        return 0;
     using ::std::sqrt;
 
-    qreal total = ::std::accumulate(histogram.cbegin(),histogram.cend(),qreal(0));
-    const int histoSize = histogram.length();
-    QVector<qreal> normalizedHistogram(histoSize);
+    const qreal total = stats.total();
+    const int last = stats.levels()-1;
 
-    // calculate the first, second, and third order moments
+    // the first, second, and third order moments
     qreal m0=1.;
-    qreal m1=0, m2=0, m3=0;
-    for (int i=0; i<histoSize; ++i)
-    {
-        normalizedHistogram[i] = histogram.at(i)/total;
-        m1 += i*normalizedHistogram.at(i);
-        m2 += i*i*normalizedHistogram.at(i);
-        m3 += i*i*i*normalizedHistogram.at(i);
-    }
+    qreal m1 = stats.moment(1,last)/total;
+    qreal m2 = stats.moment(2,last)/total;
+    qreal m3 = stats.moment(3,last)/total;
 
     qreal cd = m0*m2-m1*m1;
     qreal c0 = (m1*m3-m2*m2)/cd;
@@ -230,7 +480,7 @@ int momentsThreshold(const Histogram& histogram)
     qreal z1 = 0.5*( sqrt(c1*c1-4*c0)-c1);
     qreal pt = (z1-m1)/(z1-z0);
 
-    return pTileThreshold(histogram,pt);
+    return pTileThreshold(stats,pt);
 }
 
 /*!
@@ -252,29 +502,34 @@ int fuzzinessThreshold(const QImage& image)
     \overload fuzzinessThreshold
  */
 int fuzzinessThreshold(const Histogram& histogram)
+{
+    return fuzzinessThreshold(HistogramStats(histogram));
+}
+
+/*!
+    \overload fuzzinessThreshold
+ */
+int fuzzinessThreshold(const HistogramStats& stats)
 {
     using ::std::log;
     using ::std::abs;
 
-    const int histoSize = histogram.length();
-    // find first and last non-empty color
-    int first, last;
-    for (first=0; first<histoSize && histogram[first]==0; ++first);
-    for (last=histoSize-1; last>first && histogram[last]==0; --last);
+    if (stats.isEmpty())
+        return 0;
+    const Histogram& histogram = stats.histogram();
+    const int first = stats.first();
+    const int last = stats.last();
     if (first==last || first+1==last)
         return first;
     PROGRESS_UPDATE(0.1);
 
-    // calculate the cumulative density and the weighted cumulative density
-    QVector<qreal> s(last+1,0);
-    QVector<qreal> w(last+1,0);
-    s[0] = histogram[0];
-    for (int i= ::std::max(first,1); i<=last; ++i)
-    {
-        s[i] = s.at(i-1) + histogram.at(i);
-        w[i] = w.at(i-1) + i*histogram.at(i);
-    }
-    PROGRESS_UPDATE(0.2);
+    // the cumulative density and the weighted cumulative density
+    const auto s = [&](int i) {
+        return stats.count(i);
+    };
+    const auto w = [&](int i) {
+        return stats.moment(1,i);
+    };
 
     // precalculate the summands of the entropy given the absolute difference x-μ
     qreal c = last-first;
@@ -286,25 +541,188 @@ int fuzzinessThreshold(const Histogram& histogram)
     }
     PROGRESS_UPDATE(0.5);
 
-    // find the threshold
+    const auto lowerMean = [&](int i) {
+        return static_cast<int>(w(i)/s(i));
+    };
+    const auto upperMean = [&](int i) {
+        return static_cast<int>((w(last)-w(i))/(s(last)-s(i)));
+    };
+    const auto classEntropy = [&](int begin, int end, int mu, qreal entropy) {
+        for (int j=begin; j<=end; ++j)
+        {
+            entropy += s_mu.at(abs(j-mu))*histogram.at(j);
+        }
+        return entropy;
+    };
+
+    // move the threshold up, adding the new level to the entropy of the lower class
+    // and removing it from the upper class; a class is only summed again when its mean moves
+    QVector<qreal> entropies(last-first);
+    int lowerMu = lowerMean(first);
+    int upperMu = upperMean(first);
+    qreal lowerEntropy = classEntropy(first,first,lowerMu,0.);
+    qreal upperEntropy = classEntropy(first+1,last,upperMu,0.);
+    entropies[0] = lowerEntropy+upperEntropy;
+    for (int i=first+1; i<last; ++i)
+    {
+        if (lowerMean(i) == lowerMu)
+        {
+            lowerEntropy += s_mu.at(abs(i-lowerMu))*histogram.at(i);
+        }
+        else
+        {
+            lowerMu = lowerMean(i);
+            lowerEntropy = classEntropy(first,i,lowerMu,0.);
+        }
+        if (upperMean(i) == upperMu)
+        {
+            upperEntropy -= s_mu.at(abs(i-upperMu))*histogram.at(i);
+        }
+        else
+        {
+            upperMu = upperMean(i);
+            upperEntropy = classEntropy(i+1,last,upperMu,0.);
+        }
+        entropies[i-first] = lowerEntropy+upperEntropy;
+    }
+    PROGRESS_UPDATE(0.9);
+
+    // The running sums are off by rounding errors, so the thresholds close to the minimum are summed again
+    // in one go, to pick exactly the same one as summing every threshold would.
+    // A threshold at an empty level gives the same classes as the one below, so it is never picked.
+    const qreal tolerance = 1e-9*s(last)*(*::std::max_element(s_mu.cbegin(),s_mu.cend()));
+    const qreal bound = *::std::min_element(entropies.cbegin(),entropies.cend())+tolerance;
     int threshold = 0;
     qreal bestEntropy = ::std::numeric_limits<qreal>::max();
     for (int i=first; i<last; ++i)
     {
-        qreal entropy = 0.;
-        int mu = static_cast<int>(w.at(i)/s.at(i));
-        for (int j=first; j<=i; ++j)
+        if (histogram.at(i) == 0 || entropies.at(i-first) > bound)
+            continue;
+        qreal entropy = classEntropy(first,i,lowerMean(i),0.);
+        entropy = classEntropy(i+1,last,upperMean(i),entropy);
+        if (bestEntropy > entropy)
         {
-            entropy += s_mu.at(abs(j-mu))*histogram.at(j);
+            bestEntropy = entropy;
+            threshold = i;
         }
-        mu = static_cast<int>((w.at(last)-w.at(i))/(s.at(last)-s.at(i)));
-        for (int j=i+1; j<=last; ++j)
+    }
+    PROGRESS_UPDATE(0.99);
+
+    return threshold;
+}
+
+/*!
+    Thresholding by maximizing the sum of the entropies of the two classes.
+ */
+int entropyThreshold(const QImage& image)
+{
+/*!
+    \quotation
+    Kapur, J N, Sahoo, P K & Wong, A K C (1985), "A new method for gray-level picture thresholding
+    using the entropy of the histogram", Computer Vision, Graphics, and Image Processing 29(3): 273-285
+    \endquotation
+ */
+
+    return entropyThreshold(grayscaleHistogram(image));
+}
+
+/*!
+    \overload entropyThreshold
+ */
+int entropyThreshold(const Histogram& histogram)
+{
+    return entropyThreshold(HistogramStats(histogram));
+}
+
+/*!
+    \overload entropyThreshold
+ */
+int entropyThreshold(const HistogramStats& stats)
+{
+    if (stats.isEmpty())
+        return 0;
+    using ::std::log;
+
+    const qreal total = stats.total();
+    const qreal totalEntropySum = stats.entropySum(stats.levels()-1);
+
+    // the entropy of a class of n pixels is log(n) - Σ n_i*log(n_i) / n
+    int threshold = stats.first();
+    qreal maxEntropy = -::std::numeric_limits<qreal>::max();
+    for (int i=stats.first(); i<stats.last(); ++i)
+    {
+        const qreal count = stats.count(i);
+        const qreal entropySum = stats.entropySum(i);
+        const qreal entropy = log(count) - entropySum/count
+                + log(total-count) - (totalEntropySum-entropySum)/(total-count);
+        if (entropy > maxEntropy)
         {
-            entropy += s_mu.at(abs(j-mu))*histogram.at(j);
+            maxEntropy = entropy;
+            threshold = i;
         }
-        if (bestEntropy > entropy)
+    }
+    PROGRESS_UPDATE(0.99);
+
+    return threshold;
+}
+
+/*!
+    Thresholding by minimizing the error of classifying the pixels by two normal distributions.
+ */
+int minimumErrorThreshold(const QImage& image)
+{
+/*!
+    \quotation
+    Kittler, J & Illingworth, J (1986), "Minimum error thresholding",
+    Pattern Recognition 19(1): 41-47
+    \endquotation
+ */
+
+    return minimumErrorThreshold(grayscaleHistogram(image));
+}
+
+/*!
+    \overload minimumErrorThreshold
+ */
+int minimumErrorThreshold(const Histogram& histogram)
+{
+    return minimumErrorThreshold(HistogramStats(histogram));
+}
+
+/*!
+    \overload minimumErrorThreshold
+ */
+int minimumErrorThreshold(const HistogramStats& stats)
+{
+    if (stats.isEmpty())
+        return 0;
+    using ::std::log;
+
+    const qreal total = stats.total();
+    const int end = stats.levels()-1;
+
+    // a class contributes P*log(σ/P) to the criterion, with its fraction P and standard deviation σ,
+    // so the thresholds leaving a class of a single level are not considered
+    int threshold = stats.first();
+    qreal minError = ::std::numeric_limits<qreal>::max();
+    for (int i=stats.first(); i<stats.last(); ++i)
+    {
+        const qreal lowerCount = stats.count(i);
+        const qreal upperCount = total-lowerCount;
+        const qreal lowerMean = stats.moment(1,i)/lowerCount;
+        const qreal upperMean = (stats.moment(1,end)-stats.moment(1,i))/upperCount;
+        const qreal lowerVariance = stats.moment(2,i)/lowerCount - lowerMean*lowerMean;
+        const qreal upperVariance = (stats.moment(2,end)-stats.moment(2,i))/upperCount - upperMean*upperMean;
+        if (lowerVariance <= 0 || upperVariance <= 0)
+            continue;
+
+        const qreal lowerFraction = lowerCount/total;
+        const qreal upperFraction = upperCount/total;
+        const qreal error = lowerFraction*(0.5*log(lowerVariance)-log(lowerFraction))
+                + upperFraction*(0.5*log(upperVariance)-log(upperFraction));
+        if (error < minError)
         {
-            bestEntropy = entropy;
+            minError = error;
             threshold = i;
         }
     }
@@ -313,23 +731,671 @@ int fuzzinessThreshold(const Histogram& histogram)
     return threshold;
 }
 
+/*!
+    Thresholding by the level farthest below the line from the peak of the histogram
+    to the end of its longer tail.
+ */
+int triangleThreshold(const QImage& image)
+{
+/*!
+    \quotation
+    Zack, G W, Rogers, W E & Latt, S A (1977), "Automatic measurement of sister chromatid exchange frequency",
+    Journal of Histochemistry & Cytochemistry 25(7): 741-753
+    \endquotation
+ */
+
+    return triangleThreshold(grayscaleHistogram(image));
+}
+
+/*!
+    \overload triangleThreshold
+ */
+int triangleThreshold(const Histogram& histogram)
+{
+    return triangleThreshold(HistogramStats(histogram));
+}
+
+/*!
+    \overload triangleThreshold
+ */
+int triangleThreshold(const HistogramStats& stats)
+{
+    if (stats.isEmpty())
+        return 0;
+    const Histogram& histogram = stats.histogram();
+    const int first = stats.first();
+    const int last = stats.last();
+    if (first == last)
+        return first;
+
+    const int peak = ::std::max_element(histogram.cbegin()+first,histogram.cbegin()+last+1)-histogram.cbegin();
+    const int end = peak-first > last-peak ? first : last;
+    if (end == peak)
+        return peak;
+
+    // the vertical distance is proportional to the distance to the line
+    const qreal peakCount = histogram.at(peak);
+    const qreal slope = (qreal(histogram.at(end))-peakCount)/(end-peak);
+    const int step = end>peak ? 1 : -1;
+    int threshold = peak;
+    qreal maxDistance = 0.;
+    for (int i=peak; i!=end; i+=step)
+    {
+        const qreal distance = peakCount+slope*(i-peak)-histogram.at(i);
+        if (distance > maxDistance)
+        {
+            maxDistance = distance;
+            threshold = i;
+        }
+    }
+    PROGRESS_UPDATE(0.99);
+
+    // the dark side of the threshold is the lower class
+    return end>peak ? threshold : threshold-1;
+}
+
+/*!
+    \internal
+
+    Write the gray levels of the row \a y of \a image to \a gray.
+    The \a palette holds the gray level of every color index of an 8-bit indexed image.
+ */
+static void grayLine(const QImage& image, int y, const uchar* palette, uchar* gray)
+{
+    const int width = image.width();
+    switch (image.format())
+    {
+    case QImage::Format_Grayscale8:
+        ::std::copy_n(image.constScanLine(y),width,gray);
+        break;
+    case QImage::Format_Indexed8:
+    {
+        const uchar* line = image.constScanLine(y);
+        for (int x=0; x<width; ++x)
+        {
+            gray[x] = palette[line[x]];
+        }
+        break;
+    }
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    {
+        const QRgb* line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+        for (int x=0; x<width; ++x)
+        {
+            gray[x] = static_cast<uchar>(qGray(line[x]));
+        }
+        break;
+    }
+    default:
+        for (int x=0; x<width; ++x)
+        {
+            gray[x] = static_cast<uchar>(qGray(image.pixel(x,y)));
+        }
+        break;
+    }
+}
+
+/*!
+    \class IntegralImage
+    \brief The IntegralImage class holds the summed-area tables of the gray levels of an image.
+
+    Both the sum and the sum of squares of the gray levels of any rectangle are
+    looked up in constant time, so the local mean and variance of a window
+    cost the same for every window size.
+ */
+
+/*!
+    Construct a null integral image.
+ */
+IntegralImage::IntegralImage()
+    : w(0), h(0)
+{
+}
+
+/*!
+    Compute the summed-area tables of the gray levels of \a image.
+ */
+IntegralImage::IntegralImage(const QImage& image)
+    : w(image.width()), h(image.height()),
+      sums((w+1)*(h+1),0), squareSums((w+1)*(h+1),0)
+{
+    const int stride = w+1;
+
+    // the gray level of every color index
+    uchar palette[ColorValueRange] = {};
+    if (image.format() == QImage::Format_Indexed8)
+    {
+        const QVector<QRgb> colorTable = image.colorTable();
+        for (int i=0; i<colorTable.size() && i<int(ColorValueRange); ++i)
+        {
+            palette[i] = static_cast<uchar>(qGray(colorTable.at(i)));
+        }
+    }
+
+    // the rows are summed independently, and the columns are accumulated afterwards
+    quint64* const sumBits = sums.data();
+    quint64* const squareSumBits = squareSums.data();
+    parallelForRows(h,image.bytesPerLine(),[&](int begin, int end){
+        QVector<uchar> gray(w);
+        for (int y=begin; y<end; ++y)
+        {
+            grayLine(image,y,palette,gray.data());
+            quint64* sumLine = sumBits+(y+1)*stride+1;
+            quint64* squareSumLine = squareSumBits+(y+1)*stride+1;
+            quint64 sum = 0;
+            quint64 squareSum = 0;
+            for (int x=0; x<w; ++x)
+            {
+                const uint level = gray.at(x);
+                sum += level;
+                squareSum += level*level;
+                sumLine[x] = sum;
+                squareSumLine[x] = squareSum;
+            }
+        }
+    },0,0);
+
+    for (int y=2; y<=h; ++y)
+    {
+        quint64* sumLine = sumBits+y*stride;
+        quint64* squareSumLine = squareSumBits+y*stride;
+        for (int x=1; x<=w; ++x)
+        {
+            sumLine[x] += sumLine[x-stride];
+            squareSumLine[x] += squareSumLine[x-stride];
+        }
+    }
+}
+
+/*!
+    Return true if the integral image has no pixels.
+ */
+bool IntegralImage::isNull() const
+{
+    return w==0 || h==0;
+}
+
+/*!
+    The width of the image.
+ */
+int IntegralImage::width() const
+{
+    return w;
+}
+
+/*!
+    The height of the image.
+ */
+int IntegralImage::height() const
+{
+    return h;
+}
+
+/*!
+    The sum of the gray levels of the pixels from (\a left, \a top) to (\a right, \a bottom), inclusive.
+ */
+quint64 IntegralImage::sum(int left, int top, int right, int bottom) const
+{
+    return at(sums,left,top,right,bottom);
+}
+
+/*!
+    The sum of the squared gray levels of the pixels from (\a left, \a top) to (\a right, \a bottom), inclusive.
+ */
+quint64 IntegralImage::squareSum(int left, int top, int right, int bottom) const
+{
+    return at(squareSums,left,top,right,bottom);
+}
+
+/*!
+    \internal
+
+    Look up the rectangle from (\a left, \a top) to (\a right, \a bottom) in the summed-area \a table.
+ */
+quint64 IntegralImage::at(const QVector<quint64>& table, int left, int top, int right, int bottom) const
+{
+    Q_ASSERT_X(left>=0&&top>=0&&right<w&&bottom<h&&left<=right&&top<=bottom,__func__,"rectangle is out of range.");
+    const int stride = w+1;
+    const quint64* upper = table.constData()+top*stride;
+    const quint64* lower = table.constData()+(bottom+1)*stride;
+    return lower[right+1] - lower[left] - upper[right+1] + upper[left];
+}
+
+/*!
+    \internal
+
+    Binarize the image of \a integral, by replacing the pixels above the local threshold
+    \c threshold(mean,variance) of their window of \a radius with 1 and others with 0.
+    The windows are clipped at the borders of the image.
+ */
+template<typename ThresholdFunction>
+static QImage localBinarize_Impl(const IntegralImage& integral, uint radius, ThresholdFunction threshold)
+{
+    const int width = integral.width();
+    const int height = integral.height();
+    const int r = static_cast<int>(radius);
+    QImage binarized(width,height,QImage::Format_Mono);
+    if (integral.isNull())
+        return binarized;
+
+    uchar* const binarizedBits = binarized.bits();
+    const int binarizedStride = binarized.bytesPerLine();
+    parallelForRows(height,width*sizeof(quint64),[&](int begin, int end){
+        for (int y=begin; y<end; ++y)
+        {
+            const int top = qMax(0,y-r);
+            const int bottom = qMin(height-1,y+r);
+            uchar* line = binarizedBits+y*binarizedStride;
+            ::std::fill_n(line,binarizedStride,uchar(0));
+            for (int x=0; x<width; ++x)
+            {
+                const int left = qMax(0,x-r);
+                const int right = qMin(width-1,x+r);
+                const qreal count = (right-left+1)*(bottom-top+1);
+                const qreal mean = integral.sum(left,top,right,bottom)/count;
+                const qreal variance = qMax(0.,integral.squareSum(left,top,right,bottom)/count - mean*mean);
+                if (integral.sum(x,y,x,y) > threshold(mean,variance))
+                {
+                    line[x>>3] |= (1 << (0b111-(x & 0b111)));
+                }
+            }
+        }
+    },0,1);
+    MAYBE_INTERRUPT();
+
+    return binarized;
+}
+
+/*!
+    Niblack's local thresholding, with the threshold \c{m - weight*s} for the mean \c m
+    and the standard deviation \c s of the window of \a radius around every pixel.
+
+    Pixels above the threshold are replaced with 1 and others with 0.
+ */
+QImage niblackBinarize(const QImage& image, uint radius, qreal weight)
+{
+/*!
+    \quotation
+    Niblack, W (1986), "An introduction to digital image processing",
+    Prentice Hall: 115-116
+    \endquotation
+ */
+
+    return niblackBinarize(IntegralImage(image),radius,weight);
+}
+
+/*!
+    \overload niblackBinarize
+ */
+QImage niblackBinarize(const IntegralImage& integral, uint radius, qreal weight)
+{
+    using ::std::sqrt;
+    return localBinarize_Impl(integral,radius,[weight](qreal mean, qreal variance){
+        return mean - weight*sqrt(variance);
+    });
+}
+
+/*!
+    Sauvola's local thresholding, with the threshold \c{m*(1 + weight*(s/128 - 1))} for the mean \c m
+    and the standard deviation \c s of the window of \a radius around every pixel.
+    Unlike Niblack's method, the threshold drops below the mean only where the contrast is low.
+
+    Pixels above the threshold are replaced with 1 and others with 0.
+ */
+QImage sauvolaBinarize(const QImage& image, uint radius, qreal weight)
+{
+/*!
+    \quotation
+    Sauvola, J & Pietikainen, M (2000), "Adaptive document image binarization",
+    Pattern Recognition 33(2): 225-236
+    \endquotation
+ */
+
+    return sauvolaBinarize(IntegralImage(image),radius,weight);
+}
+
+/*!
+    \overload sauvolaBinarize
+ */
+QImage sauvolaBinarize(const IntegralImage& integral, uint radius, qreal weight)
+{
+    using ::std::sqrt;
+    constexpr qreal DeviationRange = ColorValueRange/2;
+    return localBinarize_Impl(integral,radius,[weight](qreal mean, qreal variance){
+        return mean*(1 + weight*(sqrt(variance)/DeviationRange - 1));
+    });
+}
+
+/*!
+    Bradley's local thresholding, with the threshold \c{m*(1 - weight)} for the mean \c m
+    of the window of \a radius around every pixel.
+
+    Pixels above the threshold are replaced with 1 and others with 0.
+ */
+QImage bradleyBinarize(const QImage& image, uint radius, qreal weight)
+{
+/*!
+    \quotation
+    Bradley, D & Roth, G (2007), "Adaptive thresholding using the integral image",
+    Journal of Graphics Tools 12(2): 13-21
+    \endquotation
+ */
+
+    return bradleyBinarize(IntegralImage(image),radius,weight);
+}
+
+/*!
+    \overload bradleyBinarize
+ */
+QImage bradleyBinarize(const IntegralImage& integral, uint radius, qreal weight)
+{
+    return localBinarize_Impl(integral,radius,[weight](qreal mean, qreal){
+        return mean*(1 - weight);
+    });
+}
+
+/*!
+    \internal
+
+    Reverse the order of the bits of \a byte, so that the first pixel goes to the most significant bit.
+ */
+static inline uchar reverseBits(uint byte)
+{
+    byte = ((byte&0xF0)>>4) | ((byte&0x0F)<<4);
+    byte = ((byte&0xCC)>>2) | ((byte&0x33)<<2);
+    byte = ((byte&0xAA)>>1) | ((byte&0x55)<<1);
+    return static_cast<uchar>(byte);
+}
+
+/*!
+    \internal
+
+    Pack the flags \c foreground(x) of the pixels from \a x on into whole bytes of the
+    Format_Mono scanline \a line of \a width pixels. The \a x is a multiple of 8.
+ */
+template<typename ForegroundFunction>
+static inline void packLine(int x, const int width, uchar* line, ForegroundFunction foreground)
+{
+    for (; x<width; x+=8)
+    {
+        uint byte = 0;
+        const int count = qMin(8,width-x);
+        for (int i=0; i<count; ++i)
+        {
+            byte |= uint(foreground(x+i)) << (7-i);
+        }
+        line[x>>3] = static_cast<uchar>(byte);
+    }
+}
+
+#ifdef __SSE2__
+/*!
+    \internal
+
+    Store the sign bits of the 16 bytes of \a flags as two bytes of \a output.
+ */
+static inline void storeFlags(__m128i flags, uchar* output)
+{
+    const uint mask = static_cast<uint>(_mm_movemask_epi8(flags));
+    output[0] = reverseBits(mask&0xFF);
+    output[1] = reverseBits(mask>>8);
+}
+
+/*!
+    \internal
+
+    Binarize 16 pixels at a time of the 8-bit gray \a line, keeping the levels in [\a low, \a high].
+    Returns the number of pixels done.
+ */
+static int binarizeGrayLine(const uchar* line, const int width, uchar low, uchar high, uchar* output)
+{
+    const __m128i lowV = _mm_set1_epi8(static_cast<char>(low));
+    const __m128i highV = _mm_set1_epi8(static_cast<char>(high));
+    int x = 0;
+    for (; x+16<=width; x+=16)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(line+x));
+        const __m128i aboveLow = _mm_cmpeq_epi8(_mm_max_epu8(v,lowV),v);
+        const __m128i belowHigh = _mm_cmpeq_epi8(_mm_min_epu8(v,highV),v);
+        storeFlags(_mm_and_si128(aboveLow,belowHigh),output+(x>>3));
+    }
+    return x;
+}
+
+/*!
+    \internal
+
+    Compute qGray() of 8 pixels of the 32-bit (A)RGB \a line as 16-bit integers.
+ */
+static inline __m128i grayEpi16(const QRgb* line)
+{
+    const __m128i byteMask = _mm_set1_epi32(0xFF);
+    const __m128i p0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(line));
+    const __m128i p1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(line+4));
+    const __m128i r = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0,16),byteMask),
+                                      _mm_and_si128(_mm_srli_epi32(p1,16),byteMask));
+    const __m128i g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0,8),byteMask),
+                                      _mm_and_si128(_mm_srli_epi32(p1,8),byteMask));
+    const __m128i b = _mm_packs_epi32(_mm_and_si128(p0,byteMask),_mm_and_si128(p1,byteMask));
+    // qGray() is (r*11 + g*16 + b*5)/32
+    const __m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r,_mm_set1_epi16(11)),_mm_slli_epi16(g,4)),
+                                      _mm_mullo_epi16(b,_mm_set1_epi16(5)));
+    return _mm_srli_epi16(sum,5);
+}
+
+/*!
+    \internal
+
+    Binarize 16 pixels at a time of the 32-bit (A)RGB \a line, keeping the gray levels in [\a low, \a high].
+    Returns the number of pixels done.
+ */
+static int binarizeRgbLine(const QRgb* line, const int width, uchar low, uchar high, uchar* output)
+{
+    const __m128i belowLowV = _mm_set1_epi16(static_cast<short>(low-1));
+    const __m128i highV = _mm_set1_epi16(static_cast<short>(high));
+    const auto inRange = [&](__m128i gray) {
+        return _mm_andnot_si128(_mm_cmpgt_epi16(gray,highV),_mm_cmpgt_epi16(gray,belowLowV));
+    };
+    int x = 0;
+    for (; x+16<=width; x+=16)
+    {
+        storeFlags(_mm_packs_epi16(inRange(grayEpi16(line+x)),inRange(grayEpi16(line+x+8))),output+(x>>3));
+    }
+    return x;
+}
+#endif // __SSE2__
+
+/*!
+    Create a binary image from \a image, by replacing pixels whose gray level is
+    above \a lower and not above \a upper with 1 and others with 0.
+
+    The scanlines of 8-bit grayscale and 32-bit RGB images are compared 16 pixels at a time,
+    and the pixels of 8-bit indexed images are looked up in a table of their color indices.
+    The flags are packed straight into whole bytes of the Format_Mono scanlines.
+    Other formats are converted to Format_ARGB32 first.
+ */
+QImage binarizeBetween(const QImage& image, int lower, int upper)
+{
+    const QImage::Format format = image.format();
+    if (format != QImage::Format_Grayscale8 && format != QImage::Format_Indexed8
+            && format != QImage::Format_RGB32 && format != QImage::Format_ARGB32)
+        return binarizeBetween(image.convertToFormat(QImage::Format_ARGB32),lower,upper);
+
+    const int width = image.width();
+    const int height = image.height();
+    QImage binarized(width,height,QImage::Format_Mono);
+    if (binarized.isNull())
+        return binarized;
+
+    // the flag of every gray level, and of every color index
+    const int low = qMax(0,lower+1);
+    const int high = qMin(int(ColorValueRange)-1,upper);
+    const bool isEmpty = low > high;
+    bool isForeground[ColorValueRange] = {};
+    for (int level=low; level<=high; ++level)
+    {
+        isForeground[level] = true;
+    }
+    bool isForegroundIndex[ColorValueRange] = {};
+    if (format == QImage::Format_Indexed8)
+    {
+        const QVector<QRgb> colorTable = image.colorTable();
+        for (int i=0; i<colorTable.size() && i<int(ColorValueRange); ++i)
+        {
+            isForegroundIndex[i] = isForeground[qGray(colorTable.at(i))];
+        }
+    }
+
+    uchar* const binarizedBits = binarized.bits();
+    const int binarizedStride = binarized.bytesPerLine();
+    parallelForRows(height,image.bytesPerLine(),[&](int begin, int end){
+        for (int y=begin; y<end; ++y)
+        {
+            uchar* output = binarizedBits+y*binarizedStride;
+            if (isEmpty)
+            {
+                ::std::fill_n(output,binarizedStride,uchar(0));
+                continue;
+            }
+            switch (format)
+            {
+            case QImage::Format_Grayscale8:
+            {
+                const uchar* line = image.constScanLine(y);
+                int x = 0;
+#ifdef __SSE2__
+                x = binarizeGrayLine(line,width,static_cast<uchar>(low),static_cast<uchar>(high),output);
+#endif // __SSE2__
+                packLine(x,width,output,[&](int i){
+                    return isForeground[line[i]];
+                });
+                break;
+            }
+            case QImage::Format_Indexed8:
+            {
+                const uchar* line = image.constScanLine(y);
+                packLine(0,width,output,[&](int i){
+                    return isForegroundIndex[line[i]];
+                });
+                break;
+            }
+            default:
+            {
+                const QRgb* line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+                int x = 0;
+#ifdef __SSE2__
+                x = binarizeRgbLine(line,width,static_cast<uchar>(low),static_cast<uchar>(high),output);
+#endif // __SSE2__
+                packLine(x,width,output,[&](int i){
+                    return isForeground[qGray(line[i])];
+                });
+                break;
+            }
+            }
+        }
+    },0,0);
+    MAYBE_INTERRUPT();
+
+    return binarized;
+}
+
+/*!
+    \internal
+
+    Count the gray levels \a gray of the \a width pixels of \a line in \a counts.
+    Consecutive pixels go to different sub-histograms, so that a run of pixels of the same level
+    does not wait for the previous increment to be stored before loading the count again.
+ */
+template<int SubHistograms, typename Pixel, typename GrayFunction>
+static inline void countLine(const Pixel* line, const int width, uint (*counts)[ColorValueRange],
+                             GrayFunction gray)
+{
+    int x = 0;
+    for (; x+SubHistograms<=width; x+=SubHistograms)
+    {
+        for (int i=0; i<SubHistograms; ++i)
+        {
+            ++counts[i][gray(line[x+i])];
+        }
+    }
+    for (; x<width; ++x)
+    {
+        ++counts[0][gray(line[x])];
+    }
+}
+
 /*!
     Get grayscale histogram of the \a image .
+
+    The scanlines of 8-bit grayscale, 8-bit indexed and 32-bit (A)RGB images are read directly,
+    the latter two through a palette-to-gray table and qGray() respectively.
+    Bands of rows are counted in parallel and merged.
  */
 Histogram grayscaleHistogram(const QImage& image)
 {
+    constexpr int SubHistograms = 4;
+
     Histogram histogram(ColorValueRange,0);
 
-    int height = image.height();
-    int width = image.width();
-    for (int y=0 ;y<height ;++y)
+    const int height = image.height();
+    const int width = image.width();
+    const QImage::Format format = image.format();
+
+    // the gray level of every color index
+    uchar palette[ColorValueRange] = {};
+    if (format == QImage::Format_Indexed8)
     {
-        for (int x=0 ;x<width ;++x)
+        const QVector<QRgb> colorTable = image.colorTable();
+        for (int i=0; i<colorTable.size() && i<int(ColorValueRange); ++i)
         {
-            histogram[qGray(image.pixel(x,y))] += 1;
+            palette[i] = static_cast<uchar>(qGray(colorTable.at(i)));
         }
     }
 
+    QMutex mutex;
+    parallelForRows(height,image.bytesPerLine(),[&](int begin, int end){
+        uint counts[SubHistograms][ColorValueRange] = {};
+        for (int y=begin; y<end; ++y)
+        {
+            switch (format)
+            {
+            case QImage::Format_Grayscale8:
+                countLine<SubHistograms>(image.constScanLine(y),width,counts,[](uchar value){
+                    return value;
+                });
+                break;
+            case QImage::Format_Indexed8:
+                countLine<SubHistograms>(image.constScanLine(y),width,counts,[&palette](uchar index){
+                    return palette[index];
+                });
+                break;
+            case QImage::Format_RGB32:
+            case QImage::Format_ARGB32:
+                countLine<SubHistograms>(reinterpret_cast<const QRgb*>(image.constScanLine(y)),width,counts,
+                                         [](QRgb pixel){
+                    return qGray(pixel);
+                });
+                break;
+            default:
+                for (int x=0; x<width; ++x)
+                {
+                    ++counts[x%SubHistograms][qGray(image.pixel(x,y))];
+                }
+                break;
+            }
+        }
+
+        QMutexLocker locker(&mutex);
+        for (int i=0; i<SubHistograms; ++i)
+        {
+            for (::std::size_t j=0; j<ColorValueRange; ++j)
+            {
+                histogram[j] += counts[i][j];
+            }
+        }
+    },0,0);
+
     return histogram;
 }
 
@@ -28,6 +28,7 @@
 #define THRESHOLDING_H
 
 #include <QtGlobal>
+#include <QVector>
 
 class QImage;
 
@@ -40,20 +41,97 @@ enum class AutoThresholdMethod
     Mean        = 1,
     Moments     = 2,
     Fuzziness   = 3,
+    Entropy     = 4,
+    MinimumError = 5,
+    Triangle    = 6,
+    MultiCluster = 7,
+    MultiOtsu   = AutoThresholdMethod::MultiCluster,
 };
 
 using Histogram = QVector<::std::size_t>;
 
+class HistogramStats
+{
+public:
+    explicit HistogramStats(const Histogram& histogram = Histogram());
+
+    const Histogram& histogram() const;
+    int levels() const;
+    bool isEmpty() const;
+    int first() const;
+    int last() const;
+    qreal total() const;
+    qreal count(int level) const;
+    qreal moment(int order, int level) const;
+    qreal entropySum(int level) const;
+
+private:
+    static constexpr int MomentOrders = 4;
+
+    Histogram hist;
+    QVector<qreal> moments[MomentOrders];
+    QVector<qreal> entropies;
+    int firstLevel;
+    int lastLevel;
+};
+
+class IntegralImage
+{
+public:
+    IntegralImage();
+    explicit IntegralImage(const QImage& image);
+
+    bool isNull() const;
+    int width() const;
+    int height() const;
+    quint64 sum(int left, int top, int right, int bottom) const;
+    quint64 squareSum(int left, int top, int right, int bottom) const;
+
+private:
+    quint64 at(const QVector<quint64>& table, int left, int top, int right, int bottom) const;
+
+    int w;
+    int h;
+    QVector<quint64> sums;
+    QVector<quint64> squareSums;
+};
+
 extern int meanThreshold(const QImage& image);
 extern int meanThreshold(const Histogram& histogram);
+extern int meanThreshold(const HistogramStats& stats);
 extern int pTileThreshold(const QImage& image, qreal pValue);
 extern int pTileThreshold(const Histogram& histogram, qreal pValue);
+extern int pTileThreshold(const HistogramStats& stats, qreal pValue);
 extern int clusterThreshold(const QImage& image);
 extern int clusterThreshold(const Histogram& histogram);
+extern int clusterThreshold(const HistogramStats& stats);
+extern QVector<int> clusterThresholds(const QImage& image, int count);
+extern QVector<int> clusterThresholds(const Histogram& histogram, int count);
+extern QVector<int> clusterThresholds(const HistogramStats& stats, int count);
 extern int momentsThreshold(const QImage& image);
 extern int momentsThreshold(const Histogram& histogram);
+extern int momentsThreshold(const HistogramStats& stats);
 extern int fuzzinessThreshold(const QImage& image);
 extern int fuzzinessThreshold(const Histogram& histogram);
+extern int fuzzinessThreshold(const HistogramStats& stats);
+extern int entropyThreshold(const QImage& image);
+extern int entropyThreshold(const Histogram& histogram);
+extern int entropyThreshold(const HistogramStats& stats);
+extern int minimumErrorThreshold(const QImage& image);
+extern int minimumErrorThreshold(const Histogram& histogram);
+extern int minimumErrorThreshold(const HistogramStats& stats);
+extern int triangleThreshold(const QImage& image);
+extern int triangleThreshold(const Histogram& histogram);
+extern int triangleThreshold(const HistogramStats& stats);
+
+extern QImage niblackBinarize(const QImage& image, uint radius, qreal weight);
+extern QImage niblackBinarize(const IntegralImage& integral, uint radius, qreal weight);
+extern QImage sauvolaBinarize(const QImage& image, uint radius, qreal weight);
+extern QImage sauvolaBinarize(const IntegralImage& integral, uint radius, qreal weight);
+extern QImage bradleyBinarize(const QImage& image, uint radius, qreal weight);
+extern QImage bradleyBinarize(const IntegralImage& integral, uint radius, qreal weight);
+
+extern QImage binarizeBetween(const QImage& image, int lower, int upper);
 
 extern Histogram grayscaleHistogram(const QImage& image);
 
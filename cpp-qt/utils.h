@@ -30,6 +30,10 @@
 #include <chrono>
 #include <QtDebug>
 #include <QThread>
+#include <QThreadPool>
+#include <QVector>
+#include <QFuture>
+#include <QtConcurrentRun>
 #include "progressupdater.h"
 
 #define MAYBE_INTERRUPT_X(ret)  \
@@ -56,4 +60,53 @@
 #define PROGRESS_UPDATE(percentage) \
     ProgressUpdater::instance()->increaseToValue(100.*percentage)
 
+/*!
+    \internal
+
+    Split \a rows rows into cache-sized bands, and run \c band(begin,end) for every band
+    on the global thread pool. Blocks until all bands are finished.
+
+    The calling thread updates the progress from \a progressBegin to \a progressEnd,
+    and the remaining bands are skipped once it is requested to be interrupted,
+    so the caller should check MAYBE_INTERRUPT() afterwards.
+    Every row must be computed independently of the band it belongs to,
+    so that the result is the same as the serial one.
+
+    A band has at least \a minBandRows rows, for a \a band that has to prepare
+    some rows before its first one.
+ */
+template<typename BandFunction>
+void parallelForRows(int rows, int bytesPerRow, BandFunction band,
+                     qreal progressBegin = 0, qreal progressEnd = 1, int minBandRows = 1)
+{
+    constexpr int BandBytes = 0x10000; // 64 KiB per band fits in L2 cache
+    QThread* const caller = QThread::currentThread();
+    const int threads = qMax(1,QThreadPool::globalInstance()->maxThreadCount());
+    const int bandRows = qMax(minBandRows,qBound(1,BandBytes/qMax(1,bytesPerRow),qMax(1,rows/(2*threads))));
+
+    if (bandRows >= rows || threads == 1)
+    {
+        band(0,rows);
+        PROGRESS_UPDATE((progressEnd));
+        return;
+    }
+
+    QVector<QFuture<void>> futures;
+    futures.reserve((rows+bandRows-1)/bandRows);
+    for (int begin=0; begin<rows; begin+=bandRows)
+    {
+        const int end = qMin(rows,begin+bandRows);
+        futures.append(QtConcurrent::run([&band,caller,begin,end](){
+            if (caller->isInterruptionRequested())
+                return;
+            band(begin,end);
+        }));
+    }
+    for (int i=0; i<futures.size(); ++i)
+    {
+        futures[i].waitForFinished();
+        PROGRESS_UPDATE((progressBegin+(progressEnd-progressBegin)*(i+1)/futures.size()));
+    }
+}
+
 #endif // UTILS_H